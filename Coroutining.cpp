@@ -0,0 +1,217 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Coroutining.h"
+
+#if CONFIG_PROC_HAVE_COROUTINES
+#if CONFIG_PROC_HAVE_EPOLL
+#include <poll.h>
+#include <errno.h>
+#endif
+
+using namespace std;
+
+/* Literature
+ * - https://en.cppreference.com/w/cpp/language/coroutines
+ * - https://lewissbaker.github.io/2017/11/17/understanding-operator-co-await
+ */
+
+Coroutining::Coroutining(const char *name)
+	: Processing(name)
+	, mTask()
+	, mpAwait(nullptr)
+	, mTaskCreated(false)
+{}
+
+/* member functions */
+
+Success Coroutining::process()
+{
+	if (!mTaskCreated)
+	{
+		mTaskCreated = true;
+		mTask = run();
+	}
+
+	if (!mTask.valid())
+		return procErrLog(-1, "could not create coroutine");
+
+	if (mpAwait)
+	{
+		if (!mpAwait->ready())
+		{
+			mpAwait->arm();
+			return Pending;
+		}
+
+		mpAwait = nullptr;
+	}
+
+	mTask.resume();
+	workDoneSet();
+
+	if (!mTask.done())
+		return Pending;
+
+	return mTask.result();
+}
+
+Coroutining::Task &Coroutining::Task::operator=(Task &&other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	if (mHandle)
+		mHandle.destroy();
+
+	mHandle = other.mHandle;
+	other.mHandle = nullptr;
+
+	return *this;
+}
+
+Coroutining::Task::~Task()
+{
+	if (mHandle)
+		mHandle.destroy();
+}
+
+// Parent is woken up when the child becomes undriven
+bool Coroutining::ChildAwaiting::ready()
+{
+	return !mpChild || !mpChild->progress();
+}
+
+void Coroutining::ChildAwaiting::arm()
+{
+	mpProc->idleSet();
+}
+
+Success Coroutining::ChildAwaiting::await_resume()
+{
+	if (!mpChild)
+		return -1;
+
+	return mpChild->success();
+}
+
+// Pipe wakes up the process on commit() and sourceDoneSet()
+bool Coroutining::PipeAwaiting::ready()
+{
+	return !mpPipe->isEmpty() || mpPipe->sourceDone();
+}
+
+void Coroutining::PipeAwaiting::arm()
+{
+	mpPipe->sinkProcSet(mpProc);
+	mpProc->idleSet();
+}
+
+bool Coroutining::PipeAwaiting::await_resume()
+{
+	return !mpPipe->isEmpty();
+}
+
+Coroutining::SleepAwaiting::SleepAwaiting(Coroutining *pProc, uint32_t durationMs)
+	: Awaiting(pProc)
+	, mEndMs(clockMs() + durationMs)
+{}
+
+// Process may be woken up earlier by other events
+bool Coroutining::SleepAwaiting::ready()
+{
+	return (int32_t)(clockMs() - mEndMs) >= 0;
+}
+
+void Coroutining::SleepAwaiting::arm()
+{
+	uint32_t leftMs = mEndMs - clockMs();
+
+	if ((int32_t)leftMs <= 0)
+		leftMs = 1;
+
+	mpProc->sleepSet(leftMs);
+}
+
+#if CONFIG_PROC_HAVE_EPOLL
+/*
+ * Registered descriptors are edge triggered.
+ * Readiness is therefore checked directly.
+ * Errors resume the coroutine. The next access
+ * of the descriptor reports them
+ */
+bool Coroutining::FdAwaiting::ready()
+{
+	struct pollfd pfd;
+	int res;
+
+	pfd.fd = mFd;
+	pfd.events = mWritable ? POLLOUT : POLLIN;
+	pfd.revents = 0;
+
+	res = ::poll(&pfd, 1, 0);
+	if (res > 0)
+		return true;
+
+	if (!res || errno == EINTR || errno == EAGAIN)
+		return false;
+
+	wrnLog("could not poll file descriptor %d: %s", mFd, strerror(errno));
+
+	return true;
+}
+
+void Coroutining::FdAwaiting::arm()
+{
+	if (!mRegistered)
+		mRegistered = mpProc->fdEventsAdd(mFd, mWritable);
+
+	// Without registration the descriptor is checked on every tick
+	if (!mRegistered)
+		return;
+
+	mpProc->idleSet();
+}
+
+// After resumption or with the frame of a canceled coroutine
+void Coroutining::FdAwaiting::unregister()
+{
+	if (!mRegistered)
+		return;
+
+	mpProc->fdEventsRemove(mFd);
+	mRegistered = false;
+}
+#endif
+
+/* static functions */
+
+#endif
+
@@ -0,0 +1,281 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef COROUTINING_H
+#define COROUTINING_H
+
+#include "Processing.h"
+
+#if CONFIG_PROC_HAVE_COROUTINES
+#include <coroutine>
+#include <exception>
+#include <new>
+
+#include "Pipe.h"
+
+/*
+  What is Coroutining?
+  - Opt-in base class for processes written as C++20 coroutine
+    instead of a hand-written switch (mState) state machine
+  - run() is the coroutine. It replaces process()
+    - co_await childDone(pChild)      .. Child finished. Result: success() of child
+    - co_await pipeReady(pipe)        .. Entry available or source done.
+                                         Result: true if entry available
+    - co_await sleepFor(durationMs)   .. Timer
+    - co_await fdReady(fd, writable)  .. File descriptor ready
+    - co_await until(pred)            .. Any condition. Checked on every tick
+    - co_return Positive              .. Result of process()
+  - Suspended coroutines are not ticked. The process is idle
+    or sleeping until the awaited event wakes it up
+  - initialize(), shutdown() and success() are unchanged
+  - When canceled the suspended coroutine is not resumed anymore.
+    Its frame is destroyed together with the process
+
+  Example
+    Coroutining::Task run()
+    {
+        Processing *pChild = start(ChildWorking::create());
+        Success success = co_await childDone(pChild);
+
+        if (success != Positive)
+            co_return success;
+
+        co_await sleepFor(100);
+
+        co_return Positive;
+    }
+*/
+
+class Coroutining : public Processing
+{
+
+public:
+
+	class Task
+	{
+
+	public:
+
+		struct promise_type
+		{
+			Success result = Pending;
+
+			Task get_return_object()
+			{
+				return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			// No exceptions. Frames are allocated without throwing
+			static Task get_return_object_on_allocation_failure() { return Task(); }
+			static void *operator new(size_t size) noexcept { return ::operator new(size, std::nothrow); }
+			static void operator delete(void *p) noexcept { ::operator delete(p); }
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_value(Success success) { result = success; }
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		Task() : mHandle() {}
+		Task(Task &&other) noexcept : mHandle(other.mHandle) { other.mHandle = nullptr; }
+		Task &operator=(Task &&other) noexcept;
+		~Task();
+
+		bool valid() const { return bool(mHandle); }
+		bool done() const { return mHandle.done(); }
+		void resume() { mHandle.resume(); }
+		Success result() const { return mHandle.promise().result; }
+
+	private:
+
+		explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle) {}
+
+		Task(const Task &) = delete;
+		Task &operator=(const Task &) = delete;
+
+		std::coroutine_handle<promise_type> mHandle;
+
+	};
+
+protected:
+
+	// Base of all awaitables
+	class Awaiting
+	{
+
+	public:
+
+		explicit Awaiting(Coroutining *pProc) : mpProc(pProc) {}
+		virtual ~Awaiting() {}
+
+		bool await_ready() { return ready(); }
+		void await_suspend(std::coroutine_handle<>) { mpProc->mpAwait = this; arm(); }
+
+		// Checked before the coroutine is resumed
+		virtual bool ready() = 0;
+		// Registers the event which wakes up the process
+		virtual void arm() = 0;
+
+	protected:
+
+		Coroutining *mpProc;
+
+	};
+
+	class ChildAwaiting : public Awaiting
+	{
+
+	public:
+
+		ChildAwaiting(Coroutining *pProc, Processing *pChild) : Awaiting(pProc), mpChild(pChild) {}
+
+		bool ready();
+		void arm();
+		Success await_resume();
+
+	private:
+
+		Processing *mpChild;
+
+	};
+
+	class PipeAwaiting : public Awaiting
+	{
+
+	public:
+
+		PipeAwaiting(Coroutining *pProc, PipeBase *pPipe) : Awaiting(pProc), mpPipe(pPipe) {}
+
+		bool ready();
+		void arm();
+		bool await_resume();
+
+	private:
+
+		PipeBase *mpPipe;
+
+	};
+
+	class SleepAwaiting : public Awaiting
+	{
+
+	public:
+
+		SleepAwaiting(Coroutining *pProc, uint32_t durationMs);
+
+		bool ready();
+		void arm();
+		void await_resume() {}
+
+	private:
+
+		uint32_t mEndMs;
+
+	};
+#if CONFIG_PROC_HAVE_EPOLL
+	class FdAwaiting : public Awaiting
+	{
+
+	public:
+
+		FdAwaiting(Coroutining *pProc, int fd, bool writable) : Awaiting(pProc), mFd(fd), mWritable(writable), mRegistered(false) {}
+		virtual ~FdAwaiting() { unregister(); }
+
+		bool ready();
+		void arm();
+		void await_resume() { unregister(); }
+
+	private:
+
+		void unregister();
+
+		int mFd;
+		bool mWritable;
+		bool mRegistered;
+
+	};
+#endif
+	template<typename Pred>
+	class UntilAwaiting : public Awaiting
+	{
+
+	public:
+
+		UntilAwaiting(Coroutining *pProc, Pred pred) : Awaiting(pProc), mPred(pred) {}
+
+		bool ready() { return mPred(); }
+		void arm() {}
+		void await_resume() {}
+
+	private:
+
+		Pred mPred;
+
+	};
+
+	Coroutining(const char *name);
+	virtual ~Coroutining() {}
+
+	virtual Task run() = 0;
+
+	ChildAwaiting childDone(Processing *pChild) { return ChildAwaiting(this, pChild); }
+	PipeAwaiting pipeReady(PipeBase &pipe) { return PipeAwaiting(this, &pipe); }
+	SleepAwaiting sleepFor(uint32_t durationMs) { return SleepAwaiting(this, durationMs); }
+#if CONFIG_PROC_HAVE_EPOLL
+	FdAwaiting fdReady(int fd, bool writable = false) { return FdAwaiting(this, fd, writable); }
+#endif
+	template<typename Pred>
+	UntilAwaiting<Pred> until(Pred pred) { return UntilAwaiting<Pred>(this, pred); }
+
+private:
+
+	Coroutining() = delete;
+	Coroutining(const Coroutining &) = delete;
+	Coroutining &operator=(const Coroutining &) = delete;
+
+	/* member functions */
+	Success process() final;
+
+	/* member variables */
+	Task mTask;
+	Awaiting *mpAwait;
+	bool mTaskCreated;
+
+	/* static functions */
+
+	/* static variables */
+
+	/* constants */
+
+};
+#endif
+
+#endif
+
@@ -78,7 +78,7 @@ EspWifiConnecting::EspWifiConnecting()
 
 Success EspWifiConnecting::process()
 {
-	uint32_t curTimeMs = millis();
+	uint32_t curTimeMs = clockMs();
 	uint32_t diffMs = curTimeMs - mStartMs;
 	Success success;
 	esp_err_t res;
@@ -423,10 +423,3 @@ void EspWifiConnecting::ipChanged(void *arg, esp_event_base_t event_base,
 	connected = true;
 }
 
-uint32_t EspWifiConnecting::millis()
-{
-	auto now = steady_clock::now();
-	auto nowMs = time_point_cast<milliseconds>(now);
-	return (uint32_t)nowMs.time_since_epoch().count();
-}
-
@@ -120,7 +120,6 @@ private:
 							int32_t event_id, void *event_data);
 	static void ipChanged(void *arg, esp_event_base_t event_base,
 							int32_t event_id, void *event_data);
-	static uint32_t millis();
 
 	/* static variables */
 	static bool connected;
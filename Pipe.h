@@ -55,8 +55,14 @@
     - commit()                     .. Add an entry to the queue
     - get()                        .. Get an entry from the queue
     - toPushTry()                  .. Try to push particles to children
+  - Receiving processes can be woken up on new entries
+    - sinkProcSet()
 */
 
+/*
+ * Particle times are wall clock times in milliseconds.
+ * Durations and timeouts use Processing::clockMs() instead
+ */
 #define nowMs()		((uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
 
 typedef uint32_t ParticleTime;
@@ -198,6 +204,9 @@ public:
 		Guard lock(mEntryMtx);
 #endif
 		mSourceDone = true;
+
+		if (mpProcSink)
+			mpProcSink->wakeup();
 	}
 
 	bool sinkDone() const
@@ -205,6 +214,15 @@ public:
 		return mSinkDone;
 	}
 
+	// used by receiver. Idle receivers are woken up by commit()
+	void sinkProcSet(Processing *pProc)
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mEntryMtx);
+#endif
+		mpProcSink = pProc;
+	}
+
 	// used by receiver
 	void sinkDoneSet()
 	{
@@ -229,6 +247,7 @@ protected:
 		, mSourceDone(false)
 		, mSinkDone(false)
 		, mDataBlocking(true)
+		, mpProcSink(NULL)
 	{}
 
 	virtual ~PipeBase()
@@ -245,6 +264,7 @@ protected:
 	bool mSourceDone;
 	bool mSinkDone;
 	bool mDataBlocking;
+	Processing *mpProcSink;
 
 private:
 	PipeBase()
@@ -371,6 +391,9 @@ public:
 		mEntries.emplace(std::move(particle), t1, t2);
 		++mSize;
 
+		if (mpProcSink)
+			mpProcSink->wakeup();
+
 		return 1;
 	}
 
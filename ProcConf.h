@@ -51,6 +51,135 @@
 #endif
 #endif
 
+#ifndef CONFIG_PROC_HAVE_EPOLL
+#if CONFIG_PROC_HAVE_DRIVERS && defined(__linux__)
+#define CONFIG_PROC_HAVE_EPOLL					1
+#else
+#define CONFIG_PROC_HAVE_EPOLL					0
+#endif
+#endif
+
+// Threads with ConfigDriver: Affinity, scheduling, stack size, NUMA
+#ifndef CONFIG_PROC_HAVE_PTHREAD
+#if CONFIG_PROC_HAVE_DRIVERS && defined(__linux__)
+#define CONFIG_PROC_HAVE_PTHREAD				1
+#else
+#define CONFIG_PROC_HAVE_PTHREAD				0
+#endif
+#endif
+
+// Finished internal drivers parked for reuse by start()
+#ifndef CONFIG_PROC_NUM_DRIVERS_CACHED
+#define CONFIG_PROC_NUM_DRIVERS_CACHED			8
+#endif
+
+// Parallel safe siblings ticked per fork
+#ifndef CONFIG_PROC_NUM_FORK_MAX
+#define CONFIG_PROC_NUM_FORK_MAX				16
+#endif
+
+// Opt-in migration of hot leafs between parental and internal drive
+#ifndef CONFIG_PROC_HAVE_MIGRATION
+#define CONFIG_PROC_HAVE_MIGRATION				CONFIG_PROC_HAVE_DRIVERS
+#endif
+
+#if CONFIG_PROC_HAVE_MIGRATION && !CONFIG_PROC_HAVE_DRIVERS
+#error "migration requires drivers"
+#endif
+
+// Average tick duration for promotion to an own driver
+#ifndef CONFIG_PROC_MIGRATION_HOT_US
+#define CONFIG_PROC_MIGRATION_HOT_US			1000
+#endif
+
+// Average tick duration for demotion back to parental drive
+#ifndef CONFIG_PROC_MIGRATION_COLD_US
+#define CONFIG_PROC_MIGRATION_COLD_US			100
+#endif
+
+// First parking of internal drivers after idle ticks. Doubled up to the maximum
+#ifndef CONFIG_PROC_DRIVE_LATENCY_MIN_US
+#define CONFIG_PROC_DRIVE_LATENCY_MIN_US		50
+#endif
+
+#ifndef CONFIG_PROC_SLEEP_US_REACTIVE_DEFAULT
+#define CONFIG_PROC_SLEEP_US_REACTIVE_DEFAULT	500000
+#endif
+
+// Slots per timer wheel level as power of two. Range 1 to 7
+#ifndef CONFIG_PROC_TIMER_WHEEL_SLOT_BITS
+#define CONFIG_PROC_TIMER_WHEEL_SLOT_BITS		6
+#endif
+
+// Opt-in. Processes are allocated from slab pools instead of the heap
+#ifndef CONFIG_PROC_HAVE_POOLS
+#define CONFIG_PROC_HAVE_POOLS					0
+#endif
+
+// Larger processes are allocated on the heap
+#ifndef CONFIG_PROC_POOL_SIZE_OBJ_MAX
+#define CONFIG_PROC_POOL_SIZE_OBJ_MAX			2048
+#endif
+
+#ifndef CONFIG_PROC_POOL_SIZE_SLAB
+#define CONFIG_PROC_POOL_SIZE_SLAB				16384
+#endif
+
+// Fixed capacity for slabs. Heap is used when exhausted
+#ifndef CONFIG_PROC_POOL_SIZE_STATIC
+#define CONFIG_PROC_POOL_SIZE_STATIC			0
+#endif
+
+// Driver contexts in static memory. Heap is used when exhausted
+#ifndef CONFIG_PROC_NUM_CTX_DRIVER_STATIC
+#if CONFIG_PROC_HAVE_DRIVERS
+#define CONFIG_PROC_NUM_CTX_DRIVER_STATIC		0
+#else
+#define CONFIG_PROC_NUM_CTX_DRIVER_STATIC		1
+#endif
+#endif
+
+// Free elements per size class kept by each driver
+#ifndef CONFIG_PROC_POOL_NUM_CACHED
+#define CONFIG_PROC_POOL_NUM_CACHED				32
+#endif
+
+// Tick counters and durations of processes. Load of drivers
+#ifndef CONFIG_PROC_HAVE_PROFILING
+#define CONFIG_PROC_HAVE_PROFILING				0
+#endif
+
+// Calls of initialize(), process() and shutdown() exceeding
+// a budget are logged and counted per process
+#ifndef CONFIG_PROC_HAVE_WATCHDOG
+#define CONFIG_PROC_HAVE_WATCHDOG				0
+#endif
+
+// Default budget. Changed with Processing::watchdogBudgetSet()
+#ifndef CONFIG_PROC_WATCHDOG_BUDGET_US
+#define CONFIG_PROC_WATCHDOG_BUDGET_US			50000
+#endif
+
+// Binary ring of lifecycle events per driver
+#ifndef CONFIG_PROC_HAVE_TRACE
+#define CONFIG_PROC_HAVE_TRACE					0
+#endif
+
+// Must be a power of two
+#ifndef CONFIG_PROC_TRACE_NUM_EVENTS
+#define CONFIG_PROC_TRACE_NUM_EVENTS			512
+#endif
+
+// Index of started processes. Lookup by id, name and path
+#ifndef CONFIG_PROC_HAVE_REGISTRY
+#define CONFIG_PROC_HAVE_REGISTRY				0
+#endif
+
+// Initial number of buckets. Must be a power of two
+#ifndef CONFIG_PROC_REGISTRY_NUM_BUCKETS
+#define CONFIG_PROC_REGISTRY_NUM_BUCKETS		64
+#endif
+
 #ifndef CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
 #define CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS		1
 #endif
@@ -71,6 +200,25 @@
 #endif
 #endif
 
+// Clock of the tree: std::chrono::steady_clock. Without it a
+// tick source must be set with Processing::clockSourceSet()
+#ifndef CONFIG_PROC_HAVE_CHRONO
+#if CONFIG_PROC_HAVE_LIB_STD_CPP || defined(ESP_PLATFORM)
+#define CONFIG_PROC_HAVE_CHRONO					1
+#else
+#define CONFIG_PROC_HAVE_CHRONO					0
+#endif
+#endif
+
+// Base class Coroutining. Requires C++20
+#ifndef CONFIG_PROC_HAVE_COROUTINES
+#if defined(__cpp_impl_coroutine) && CONFIG_PROC_HAVE_LIB_STD_CPP
+#define CONFIG_PROC_HAVE_COROUTINES				1
+#else
+#define CONFIG_PROC_HAVE_COROUTINES				0
+#endif
+#endif
+
 #ifndef CONFIG_PROC_USE_DRIVER_COLOR
 #define CONFIG_PROC_USE_DRIVER_COLOR			1
 #endif
@@ -30,6 +30,26 @@
 
 #include "Processing.h"
 
+#if CONFIG_PROC_HAVE_DRIVERS
+#include <atomic>
+#include <condition_variable>
+#endif
+#if CONFIG_PROC_HAVE_EPOLL
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#if CONFIG_PROC_HAVE_PTHREAD
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
 #if CONFIG_PROC_HAVE_CORE_LOG
 #define coreLog(m, ...)					(genericLog(5, NULL, 0, m, ##__VA_ARGS__))
 #define procCoreLog(m, ...)				(genericLog(5, this, 0, m, ##__VA_ARGS__))
@@ -61,14 +81,50 @@ enum ProcessState
 	PsFinished,
 };
 
+enum ProcProfileIdx
+{
+	PpInit = 0,
+	PpProcess,
+	PpShutdown,
+};
+
+#if CONFIG_PROC_HAVE_PROFILING || CONFIG_PROC_HAVE_WATCHDOG
+#define dHookEnter()			hookEnter(&frameHook)
+#define dHookLeave(idx)			hookLeave(idx, &frameHook)
+#else
+#define dHookEnter()
+#define dHookLeave(idx)
+#endif
+
 enum ProcStatBitParent
 {
 	PsbParStarted = 1,
 	PsbParCanceled = 2,
 	PsbParUnused = 4,
 	PsbParWhenFinishedUnused = 8,
+	PsbParStatic = 16,
+};
+
+enum SuccessCounted
+{
+	ScNone = 0,
+	ScPending,
+	ScPositive,
+	ScFailed,
+};
+
+#if CONFIG_PROC_HAVE_MIGRATION
+enum ProcStatBitMigr
+{
+	PsbMigrEnabled = 1,
+	PsbMigrFd = 2,
+	PsbMigrPending = 4,
+	PsbMigrCnt = 0xF0,
 };
 
+#define dMigrCntOne		0x10
+#endif
+
 enum ProcStatBitDriver
 {
 	PsbDrvInitDone = 1,
@@ -76,1104 +132,5578 @@ enum ProcStatBitDriver
 	PsbDrvShutdownDone = 4,
 	PsbDrvUndriven = 8,
 	PsbDrvPrTreeDisable = 16,
+	PsbDrvFdEvent = 32,
+	PsbDrvIdle = 64,
+	PsbDrvWorkDone = 128,
+};
+
+/*
+ * Lifecycle fields are polled by parents on other drivers.
+ * Results are published with release before the flags
+ * announcing them. Pollers read with acquire.
+ * Bits used by the own driver only are accessed relaxed.
+ * Modifications are atomic because several threads set
+ * bits of the same field
+ */
+#if CONFIG_PROC_HAVE_DRIVERS
+#define dLoadAcq(x)			(x).load(memory_order_acquire)
+#define dLoadRlx(x)			(x).load(memory_order_relaxed)
+#define dStoreRel(x, v)		(x).store(v, memory_order_release)
+#define dStoreRlx(x, v)		(x).store(v, memory_order_relaxed)
+#define dOrRel(x, v)			(x).fetch_or(v, memory_order_release)
+#define dOrRlx(x, v)			(x).fetch_or(v, memory_order_relaxed)
+#define dClearRlx(x, v)		(x).fetch_and((uint8_t)~(v), memory_order_relaxed)
+#else
+#define dLoadAcq(x)			(x)
+#define dLoadRlx(x)			(x)
+#define dStoreRel(x, v)		((x) = (v))
+#define dStoreRlx(x, v)		((x) = (v))
+#define dOrRel(x, v)			((x) |= (v))
+#define dOrRlx(x, v)			((x) |= (v))
+#define dClearRlx(x, v)		((x) &= (uint8_t)~(v))
+#endif
+
+enum ProcStatBitSched
+{
+	PsbSchedParallel = 1,
+	PsbSchedParallelChildren = 2,
+	PsbSchedTeardownBulk = 4,
+	PsbSchedWeight = 0xF0,
 };
 
+#define dWeightShift	4
+#define dWeightMax	16
+
 #if CONFIG_PROC_HAVE_LIB_STD_CPP || CONFIG_PROC_HAVE_DRIVERS
 using namespace std;
 #endif
 
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-typedef list<Processing *>::iterator ChildIter;
+#if CONFIG_PROC_HAVE_DRIVERS
+typedef atomic<uint32_t> CntPool;
+#else
+typedef uint32_t CntPool;
 #endif
 
-uint8_t Processing::showAddressInId = CONFIG_PROC_SHOW_ADDRESS_IN_ID;
-uint8_t Processing::disableTreeDefault = CONFIG_PROC_DISABLE_TREE_DEFAULT;
-
-#if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
+static void *heapAlloc(size_t size)
+{
 #if CONFIG_PROC_HAVE_LIB_STD_CPP
-list<FuncGlobDestruct> Processing::globalDestructors;
+	return ::operator new(size, std::nothrow);
 #else
-FuncGlobDestruct *Processing::pGlobalDestructors = NULL;
-#endif
+	return ::operator new(size);
 #endif
+}
 
-#if CONFIG_PROC_HAVE_DRIVERS
-size_t Processing::sleepInternalDriveUs = 2000;
-size_t Processing::numBurstInternalDrive = 13;
-FuncInternalDrive Processing::pFctInternalDrive = Processing::internalDrive;
-FuncDriverInternalCreate Processing::pFctDriverInternalCreate = Processing::driverInternalCreate;
-FuncDriverInternalCleanUp Processing::pFctDriverInternalCleanUp = Processing::driverInternalCleanUp;
-#endif
+static void heapFree(void *p, size_t size)
+{
+	(void)size;
+	::operator delete(p);
+}
 
-/* Literature
- * - http://man7.org/linux/man-pages/man5/proc.5.html
- * - https://stackoverflow.com/questions/6261201/how-to-find-memory-leak-in-a-c-code-project
+#if CONFIG_PROC_HAVE_POOLS
+#define dPoolHdrSize		16
+#define dPoolGranularity	32
+#define dNumPools			(CONFIG_PROC_POOL_SIZE_OBJ_MAX / dPoolGranularity)
+#define dIdxPoolHeap		0xFF
+
+/*
+ * Processes are allocated from slabs of their size class.
+ * Every slab has its own free list. Pools list their slabs
+ * having free elements. A slab on the heap is released when
+ * its last element has been freed and its pool has another
+ * slab with free elements.
+ * - Hit: Element taken from a free list
+ * - Miss: New element carved from slab or allocated on heap
+ * Each element has a header with its pool and its slab.
+ * With drivers, every thread caches some free elements
+ * of each size class to avoid locking. Cached elements
+ * keep their slabs
+ * Literature
+ * - https://www.usenix.org/legacy/publications/library/proceedings/bos94/full_papers/bonwick.a
  */
+struct PoolElem
+{
+	PoolElem *pNext;
+};
 
-// This area is used by the client
+struct PoolSlab
+{
+	PoolSlab *pNext;
+	PoolSlab *pPrev;
+	PoolElem *pFree;
+	uint8_t *pCur;
+	uint8_t *pEnd;
+	uint32_t numUsed;
+	bool listed;
+	bool isStatic;
+};
+
+#define dPoolSlabHdrSize	((sizeof(PoolSlab) + dPoolHdrSize - 1) / dPoolHdrSize * dPoolHdrSize)
 
-void Processing::treeTick()
+struct PoolHdr
 {
-	// No need to lock child list here
+	PoolSlab *pSlab;
+	uint8_t idx;
+};
 
-	Processing *pChild = NULL;
-	Success sSuccess;
-	bool childCanBeRemoved;
+static_assert(sizeof(PoolHdr) <= dPoolHdrSize, "pool header too large");
 
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-	ChildIter iter = mChildList.begin();
-	while (iter != mChildList.end())
-	{
-		pChild = *iter;
-#else
-	Processing **pChildListElem = mpChildList;
-	while (pChildListElem && *pChildListElem)
-	{
-		pChild = *pChildListElem;
+struct ProcPool
+{
+	PoolSlab *pSlabFirst;
+	CntPool numUsed;
+	CntPool numHits;
+	CntPool numMisses;
+	CntPool numSlabs;
+};
+
+static ProcPool pools[dNumPools];
+#if CONFIG_PROC_POOL_SIZE_STATIC
+alignas(dPoolHdrSize) static uint8_t bufPoolStatic[CONFIG_PROC_POOL_SIZE_STATIC];
+static size_t szPoolStaticUsed = 0;
+#endif
+#if CONFIG_PROC_HAVE_DRIVERS
+static mutex mtxPools;
 #endif
-		parentalDrive(pChild);
 
-		childCanBeRemoved = pChild->mStatDrv & PsbDrvUndriven &&
-						pChild->mStatParent & PsbParUnused;
+static size_t poolSizeElem(size_t idx)
+{
+	return dPoolHdrSize + (idx + 1) * dPoolGranularity;
+}
 
-		if (!childCanBeRemoved)
-		{
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-			++iter;
-#else
-			++pChildListElem;
-#endif
-			continue;
-		}
+// Pools must be locked
+static void poolSlabList(ProcPool *pPool, PoolSlab *pSlab)
+{
+	pSlab->pPrev = NULL;
+	pSlab->pNext = pPool->pSlabFirst;
 
-		char childId[CONFIG_PROC_ID_BUFFER_SIZE];
-		procId(childId, childId + sizeof(childId), pChild);
+	if (pSlab->pNext)
+		pSlab->pNext->pPrev = pSlab;
 
-		procCoreLog("removing %s from child list", childId);
-		{
-#if CONFIG_PROC_HAVE_DRIVERS
-			procCoreLog("Locking mChildListMtx");
-			Guard lock(mChildListMtx);
-			procCoreLog("Locking mChildListMtx: done");
-#endif
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-			iter = mChildList.erase(iter);
-			--mNumChildren;
-#else
-			pChildListElem = childElemErase(pChildListElem);
-#endif
-		}
-		procCoreLog("removing %s from child list: done", childId);
+	pPool->pSlabFirst = pSlab;
+	pSlab->listed = true;
+}
 
-		destroy(pChild);
-	}
+// Pools must be locked
+static void poolSlabUnlist(ProcPool *pPool, PoolSlab *pSlab)
+{
+	if (pSlab->pPrev)
+		pSlab->pPrev->pNext = pSlab->pNext;
+	else
+		pPool->pSlabFirst = pSlab->pNext;
 
-	// Only after this point children can be created or destroyed
-	// and therefore added or removed from the child list
+	if (pSlab->pNext)
+		pSlab->pNext->pPrev = pSlab->pPrev;
+
+	pSlab->listed = false;
+}
 
-	switch (mStateAbstract)
+// Pools must be locked
+static PoolSlab *poolSlabCreate(ProcPool *pPool, size_t sizeElem)
+{
+	size_t sizeSlab = CONFIG_PROC_POOL_SIZE_SLAB;
+	uint8_t *pMem = NULL;
+	PoolSlab *pSlab;
+	bool isStatic = false;
+
+	if (sizeSlab < dPoolSlabHdrSize + sizeElem)
+		sizeSlab = dPoolSlabHdrSize + sizeElem;
+#if CONFIG_PROC_POOL_SIZE_STATIC
+	if (szPoolStaticUsed + sizeSlab <= sizeof(bufPoolStatic))
 	{
-	case PsExistent:
+		pMem = &bufPoolStatic[szPoolStaticUsed];
+		szPoolStaticUsed += sizeSlab;
+		isStatic = true;
+	}
+#endif
+	if (!pMem)
+	{
+		pMem = (uint8_t *)heapAlloc(sizeSlab);
+		if (!pMem)
+			return NULL;
+	}
 
-#if CONFIG_PROC_HAVE_DRIVERS
-// cpp -dM /dev/null
-#if defined(CONFIG_PROC_TITLE_NEW_DRIVER)
-		// Only for worker threads
-		if (mDriver == DrivenByNewInternalDriver)
-		{
-			char buf[32];
-			char *pBuf = buf;
-			char *pBufEnd = pBuf + sizeof(buf);
+	pSlab = (PoolSlab *)(void *)pMem;
 
-			dInfo("%p", (const void *)this);
-#if defined(__linux__)
-			int res;
-			res = prctl(PR_SET_NAME, buf, 0, 0, 0);
-			if (res < 0)
-				procWrnLog("could not set driver name via prctl()");
-#elif defined(__FreeBSD__)
-			setproctitle("%s", buf);
-#endif
-		}
-#endif
-#endif
-		if (mStatParent & PsbParCanceled)
-		{
-			procCoreLog("process canceled during state existent");
-			mStateAbstract = PsFinishedPrepare;
-			break;
-		}
+	pSlab->pFree = NULL;
+	pSlab->pCur = pMem + dPoolSlabHdrSize;
+	pSlab->pEnd = pMem + sizeSlab;
+	pSlab->numUsed = 0;
+	pSlab->isStatic = isStatic;
 
-		procCoreLog("initializing()");
-		mStateAbstract = PsInitializing;
+	poolSlabList(pPool, pSlab);
+	++pPool->numSlabs;
 
-		break;
-	case PsInitializing:
+	return pSlab;
+}
 
-		if (mStatParent & PsbParCanceled)
-		{
-			procCoreLog("process canceled during initializing");
-			procCoreLog("downShutting()");
-			mStateAbstract = PsDownShutting;
-			break;
-		}
+// Pools must be locked
+static uint8_t *poolElemGet(ProcPool *pPool, size_t idx)
+{
+	size_t sizeElem = poolSizeElem(idx);
+	PoolSlab *pSlab = pPool->pSlabFirst;
+	PoolElem *pElem;
+	uint8_t *pHdr;
 
-		sSuccess = initialize(); // child list may be changed here
+	if (!pSlab)
+		pSlab = poolSlabCreate(pPool, sizeElem);
 
-		if (sSuccess == Pending)
-			break;
+	if (!pSlab)
+		return NULL;
 
-		if (sSuccess != Positive)
-		{
-			mSuccess = sSuccess;
-			procCoreLog("initializing(): failed. success = %d", int(mSuccess));
-			procCoreLog("downShutting()");
-			mStateAbstract = PsDownShutting;
-			break;
-		}
+	pElem = pSlab->pFree;
+	if (pElem)
+	{
+		pSlab->pFree = pElem->pNext;
+		++pPool->numHits;
 
-		procCoreLog("initializing(): done");
-		mStatDrv |= PsbDrvInitDone;
+		pHdr = (uint8_t *)pElem - dPoolHdrSize;
+	}
+	else
+	{
+		++pPool->numMisses;
 
-		procCoreLog("processing()");
-		mStateAbstract = PsProcessing;
+		pHdr = pSlab->pCur;
+		pSlab->pCur += sizeElem;
 
-		break;
-	case PsProcessing:
+		((PoolHdr *)(void *)pHdr)->pSlab = pSlab;
+		((PoolHdr *)(void *)pHdr)->idx = (uint8_t)idx;
+	}
 
-		if (mStatParent & PsbParCanceled)
-		{
-			procCoreLog("process canceled during processing");
-			procCoreLog("downShutting()");
-			mStateAbstract = PsDownShutting;
-			break;
-		}
+	++pSlab->numUsed;
 
-		sSuccess = process(); // child list may be changed here
+	if (!pSlab->pFree && pSlab->pCur + sizeElem > pSlab->pEnd)
+		poolSlabUnlist(pPool, pSlab);
 
-		if (sSuccess == Pending)
-			break;
+	return pHdr + dPoolHdrSize;
+}
 
-		mSuccess = sSuccess;
+// Pools must be locked
+static void poolElemPut(ProcPool *pPool, PoolElem *pElem)
+{
+	PoolHdr *pHdr = (PoolHdr *)(void *)((uint8_t *)pElem - dPoolHdrSize);
+	PoolSlab *pSlab = pHdr->pSlab;
 
-		procCoreLog("processing(): done. success = %d", int(mSuccess));
-		mStatDrv |= PsbDrvProcessDone;
+	pElem->pNext = pSlab->pFree;
+	pSlab->pFree = pElem;
 
-		procCoreLog("downShutting()");
-		mStateAbstract = PsDownShutting;
+	if (!pSlab->listed)
+		poolSlabList(pPool, pSlab);
 
-		break;
-	case PsDownShutting:
+	if (--pSlab->numUsed || pSlab->isStatic)
+		return;
 
-		sSuccess = shutdown(); // child list may be changed here
+	// Keep one slab with free elements
+	if (pPool->pSlabFirst == pSlab && !pSlab->pNext)
+		return;
 
-		if (sSuccess == Pending)
-			break;
+	poolSlabUnlist(pPool, pSlab);
+	--pPool->numSlabs;
 
-		procCoreLog("downShutting(): done");
-		mStatDrv |= PsbDrvShutdownDone;
+	heapFree(pSlab, (size_t)(pSlab->pEnd - (uint8_t *)pSlab));
+}
+#if CONFIG_PROC_HAVE_DRIVERS
+struct PoolCache
+{
+	~PoolCache()
+	{
+		PoolElem *pElem;
 
-		mStateAbstract = PsChildrenUnusedSet;
+		closed = true;
 
-		break;
-	case PsChildrenUnusedSet:
+		Guard lock(mtxPools);
 
-		procCoreLog("marking children as unused");
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-		iter = mChildList.begin();
-		while (iter != mChildList.end())
+		for (size_t idx = 0; idx < dNumPools; ++idx)
 		{
-			pChild = *iter++;
-#else
-		pChildListElem = mpChildList;
-		while (pChildListElem && *pChildListElem)
-		{
-			pChild = *pChildListElem++;
-#endif
-			pChild->unusedSet();
-		}
-		procCoreLog("marking children as unused: done");
+			while (pFree[idx])
+			{
+				pElem = pFree[idx];
+				pFree[idx] = pElem->pNext;
 
-		mStateAbstract = PsFinishedPrepare;
+				poolElemPut(&pools[idx], pElem);
+			}
 
-		break;
-	case PsFinishedPrepare:
+			numFree[idx] = 0;
+		}
+	}
 
-		procCoreLog("preparing finish");
+	PoolElem *pFree[dNumPools];
+	uint16_t numFree[dNumPools];
+	bool closed;
+};
 
-		if (mStatParent & PsbParWhenFinishedUnused)
-		{
-			procCoreLog("set process as unused when finished");
-			unusedSet();
-		}
+static thread_local PoolCache poolCache;
+#endif
 
-		procCoreLog("preparing finish: done -> finished");
+static void *poolAlloc(size_t size)
+{
+	PoolHdr *pHdr;
 
-		mStateAbstract = PsFinished;
+	if (!size)
+		size = 1;
 
-		break;
-	case PsFinished:
+	if (size > CONFIG_PROC_POOL_SIZE_OBJ_MAX)
+	{
+		pHdr = (PoolHdr *)heapAlloc(dPoolHdrSize + size);
+		if (!pHdr)
+			return NULL;
 
-		break;
-	default:
-		break;
+		pHdr->pSlab = NULL;
+		pHdr->idx = dIdxPoolHeap;
+
+		return (uint8_t *)pHdr + dPoolHdrSize;
 	}
-}
 
-bool Processing::progress() const
-{
-	return mStateAbstract != PsFinished || mNumChildren;
-}
+	size_t idx = (size - 1) / dPoolGranularity;
+	ProcPool *pPool = &pools[idx];
+	uint8_t *pElem;
+#if CONFIG_PROC_HAVE_DRIVERS
+	PoolCache *pCache = &poolCache;
+	PoolElem *pCached = pCache->pFree[idx];
 
-Success Processing::success() const
-{
-	return mSuccess;
-}
+	if (pCached)
+	{
+		pCache->pFree[idx] = pCached->pNext;
+		--pCache->numFree[idx];
 
-void Processing::unusedSet()
-{
-	uint8_t flags = PsbParCanceled | PsbParUnused;
-	mStatParent |= flags;
-}
+		++pPool->numHits;
+		++pPool->numUsed;
 
-void Processing::procTreeDisplaySet(bool display)
-{
-	if (display)
-		mStatDrv &= ~PsbDrvPrTreeDisable;
-	else
-		mStatDrv |= PsbDrvPrTreeDisable;
-}
+		return pCached;
+	}
 
-void Processing::argSet(void *pArg)
-{
-	mpArg = pArg;
-}
+	Guard lock(mtxPools);
+#endif
+	pElem = poolElemGet(pPool, idx);
+	if (pElem)
+		++pPool->numUsed;
 
-bool Processing::initDone() const		{ return mStatDrv & PsbDrvInitDone;	}
-bool Processing::processDone() const	{ return mStatDrv & PsbDrvProcessDone;	}
-bool Processing::shutdownDone() const	{ return mStatDrv & PsbDrvShutdownDone;	}
+	return pElem;
+}
 
-size_t Processing::processTreeStr(char *pBuf, char *pBufEnd, bool detailed, bool colored)
+static void poolFree(void *p, size_t size)
 {
-	Processing *pChild = NULL;
-	static char bufInfo[CONFIG_PROC_INFO_BUFFER_SIZE];
-	const char *pBufStart = pBuf;
-	const char *pBufLineStart;
-	char *pBufIter;
-	uint16_t numIndent;
-	int8_t n, lastChildInfoLine;
-	int8_t cntChildDrawn;
-	size_t numWritten;
-
-	if (mStatDrv & PsbDrvPrTreeDisable)
-		return 0;
+	if (!p)
+		return;
 
-	if (!pBuf || !(pBufEnd - pBuf))
-		return 0;
+	PoolHdr *pHdr = (PoolHdr *)(void *)((uint8_t *)p - dPoolHdrSize);
+	size_t idx = pHdr->idx;
 
-	for (n = 0; n < 2 * mLevelTree; ++n)
-		dInfo(" ");
+	if (idx == dIdxPoolHeap)
+	{
+		heapFree(pHdr, dPoolHdrSize + size);
+		return;
+	}
 
-	if (mSuccess == Pending)
-		dInfo("-");
-	else if (mSuccess == Positive)
-		dInfo("+");
-	else
-		dInfo("x");
+	ProcPool *pPool = &pools[idx];
+	PoolElem *pElem = (PoolElem *)p;
 
-	dInfo(" ");
+	--pPool->numUsed;
+#if CONFIG_PROC_HAVE_DRIVERS
+	PoolCache *pCache = &poolCache;
 
-	if (mDriver == DrivenByExternalDriver)
+	if (!pCache->closed && pCache->numFree[idx] < CONFIG_PROC_POOL_NUM_CACHED)
 	{
-#if CONFIG_PROC_USE_DRIVER_COLOR
-		if (colored)
-			dInfo("\033[38;5;135m");
-		else
-#endif
-			dInfo("### ");
+		pElem->pNext = pCache->pFree[idx];
+		pCache->pFree[idx] = pElem;
+		++pCache->numFree[idx];
+
+		return;
 	}
 
-#if CONFIG_PROC_USE_DRIVER_COLOR
-	if (colored && !mLevelDriver)
-		dInfo("\033[38;5;40m");
+	Guard lock(mtxPools);
 #endif
-
-	if (mDriver == DrivenByNewInternalDriver)
-	{
-#if CONFIG_PROC_USE_DRIVER_COLOR
-		if (colored)
-			dInfo("\033[38;5;81m");
-		else
+	poolElemPut(pPool, pElem);
+}
 #endif
-			dInfo("*** ");
-	}
 
-	pBuf += procId(pBuf, pBufEnd, this);
-	dInfo("()\r\n");
+#define dTmrSlotBits		CONFIG_PROC_TIMER_WHEEL_SLOT_BITS
+#define dNumTmrSlots		(1 << dTmrSlotBits)
+#define dTmrSlotMask		(dNumTmrSlots - 1)
+#define dNumTmrLevels		4
+#define dTmrDelayMax		((uint32_t)1 << (dTmrSlotBits * dNumTmrLevels))
 
-#if CONFIG_PROC_USE_DRIVER_COLOR
-	if (colored)
-		dInfo("\033[37m");
+// Delays of all levels must fit into 31 bits of milliseconds
+#if CONFIG_PROC_TIMER_WHEEL_SLOT_BITS < 1 || CONFIG_PROC_TIMER_WHEEL_SLOT_BITS * dNumTmrLevels > 31
+#error "timer wheel slot bits must be in range 1 to 7"
 #endif
-	numIndent = 2 * mLevelTree + 2;
-
-	if (detailed && mStateAbstract != PsFinished)
-	{
-		bufInfo[0] = 0;
-		processInfo(bufInfo, bufInfo + sizeof(bufInfo));
-		bufInfo[sizeof(bufInfo) - 1] = 0;
 
-		pBufLineStart = pBufIter = bufInfo;
-		lastChildInfoLine = 0;
+/*
+ * Hierarchical timer wheel with a resolution of one millisecond.
+ * Level n covers delays up to (2^(slot bits))^(n + 1) ms.
+ * Longer delays are split. Timers of higher levels are moved
+ * to lower levels when the time of the lower level wraps.
+ * Insertion, removal and expiry are O(1).
+ * Literature
+ * - http://www.cs.columbia.edu/~nahum/w6998/papers/sosp87-timing-wheels.pdf
+ */
+struct TimerWheel
+{
+	uint32_t tMs;
+	uint32_t numTimers;
+	Processing *slots[dNumTmrLevels][dNumTmrSlots];
+};
 
-		while (1)
-		{
-			if (pBufIter >= bufInfo + sizeof(bufInfo))
-				break;
+/*
+ * Every driver has exactly one context.
+ * It is owned by the process which is driven directly
+ * by the driver (root of the driver). All processes
+ * driven by their parent share the context of the root.
+ * - Parking of the driver: Sleep, condition variable or epoll
+ * - Registered file descriptors and wakeup timeout
+ * - Timers of sleeping processes
+ * - Processes woken up by other drivers. Lock free stack
+ * - Removed children still visible to tree readers
+ * - Busy and idle time of the driver
+ * - Ring of trace events. Written by the driver only
+ */
+struct TraceEvent
+{
+	uint64_t tNs;
+	const void *pProc;
+	const char *pStr;
+	uint8_t type;
+	uint8_t valOld;
+	uint8_t valNew;
+};
 
-			if (!bufInfo[0])
-				break;
+/*
+ * File descriptor registered with fdEventsAdd().
+ * Registrations are removed from epoll before their
+ * process is freed. Otherwise epoll_wait() would
+ * report a freed process
+ */
+struct FdRegistration
+{
+	FdRegistration *pNext;
+	Processing *pProc;
+	int fd;
+	uint32_t events;
+};
 
-			if (*pBufIter && *pBufIter != '\n')
-			{
-				++pBufIter;
-				continue;
-			}
+struct DriverContext
+{
+	Processing *pRoot;
+	bool reactive;
+	TimerWheel wheel;
+#if CONFIG_PROC_HAVE_DRIVERS
+	atomic<Processing *> pWakeFirst;
+#else
+	Processing *pWakeFirst;
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+	// Load. Written by the driver only. See ProcProfile
+	Cnt64Proc durBusyNs;
+	Cnt64Proc durIdleNs;
+	uint64_t tWaitEndNs;
+	FlagProc profResetReq;
+#endif
+#if CONFIG_PROC_HAVE_TRACE
+	DriverContext *pTraceNext;
+	DriverContext *pTracePrev;
+	TraceEvent *pEvents;
+	uint32_t idDriver;
+#if CONFIG_PROC_HAVE_DRIVERS
+	atomic<uint32_t> idxEventNext;
+#else
+	uint32_t idxEventNext;
+#endif
+#endif
+#if CONFIG_PROC_HAVE_DRIVERS
+	Processing *pRetiredFirst;
+	DriverContext *pCtxRetiredFirst;
+	DriverContext *pCtxRetiredNext;
+	uint32_t epochRetired;
+	uint32_t latencyMinUs;
+	uint32_t latencyMaxUs;
+	size_t numTicksIdle;
+	size_t numTicksBusy;
+	size_t delayParkUs;
+	bool timeoutSet;
+	chrono::steady_clock::time_point tTimeout;
+	mutex mtxWait;
+	condition_variable cvWait;
+	atomic<bool> wakeupPending;
+	// Snapshots of processInfo() requested by renderers
+	atomic<bool> infoReq;
+	atomic<uint32_t> numForks;
+	mutex mtxFork;
+#endif
+#if CONFIG_PROC_HAVE_EPOLL
+	atomic<int> fdEpoll;
+	int fdWakeup;
+	FdRegistration *pFdRegFirst;
+#endif
+};
 
-			if (!*pBufIter)
-			{
-				if (!*(pBufIter - 1)) // last line drawn already
-					break;
+#if CONFIG_PROC_NUM_CTX_DRIVER_STATIC
+static DriverContext ctxDriverStatic[CONFIG_PROC_NUM_CTX_DRIVER_STATIC];
+static bool ctxDriverStaticUsed[CONFIG_PROC_NUM_CTX_DRIVER_STATIC];
+#endif
 
-				lastChildInfoLine = 1;
-			}
+#if CONFIG_PROC_HAVE_DRIVERS
+/*
+ * Threads of internal drivers are parked when their process
+ * has finished. Up to CONFIG_PROC_NUM_DRIVERS_CACHED of them
+ * are kept in a cache and reused by start(). Others exit
+ * and are joined by later clean ups or by applicationClose().
+ * Threads with scheduling settings are not reused.
+ * The parent doesn't wait for the driver to leave. The last
+ * one of both retires the driver
+ */
+struct DriverInternal
+{
+	FuncInternalDrive pFctDrive;
+	void *pProc;
+	bool driving;
+	bool released;
+	bool reusable;
+	bool exit;
+	bool exited;
+	mutex mtxPark;
+	condition_variable cvPark;
+	DriverInternal *pCachedNext;
+#if CONFIG_PROC_HAVE_PTHREAD
+	ConfigDriver config;
+	char name[16];
+	pthread_t thread;
+#else
+	thread *pThread;
+#endif
+};
 
-			for (n = 0; n < numIndent; ++n)
-				dInfo(" ");
+static DriverInternal *pDrvCachedFirst = NULL;
+static size_t numDrvCached = 0;
+static DriverInternal *pDrvExitFirst = NULL;
+static size_t numDrvReleasing = 0;
+static mutex mtxDrvCached;
+static condition_variable cvDrvRetired;
 
-			*pBufIter = 0; // terminate current line starting at pBufLineStart
+static bool driverCachedPush(DriverInternal *pDrv)
+{
+	Guard lock(mtxDrvCached);
 
-			dInfo("%s\r\n", pBufLineStart);
+	if (numDrvCached >= CONFIG_PROC_NUM_DRIVERS_CACHED)
+		return false;
 
-			++pBufIter;
-			pBufLineStart = pBufIter;
+	pDrv->pCachedNext = pDrvCachedFirst;
+	pDrvCachedFirst = pDrv;
+	++numDrvCached;
 
-			if (lastChildInfoLine)
-				break;
-		}
-	}
+	return true;
+}
 
-	cntChildDrawn = 0;
+static DriverInternal *driverCachedPop()
+{
+	Guard lock(mtxDrvCached);
+	DriverInternal *pDrv = pDrvCachedFirst;
 
-	{
-#if CONFIG_PROC_HAVE_DRIVERS
-		Guard lock(mChildListMtx);
-#endif
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-		ChildIter iter = mChildList.begin();
-		while (iter != mChildList.end())
-		{
-			pChild = *iter++;
-#else
-		Processing **pChildListElem = mpChildList;
-		while (pChildListElem && *pChildListElem)
-		{
-			pChild = *pChildListElem++;
-#endif
-			numWritten = pChild->processTreeStr(pBuf, pBufEnd, detailed, colored);
+	if (!pDrv)
+		return NULL;
 
-			pBuf += numWritten;
+	pDrvCachedFirst = pDrv->pCachedNext;
+	pDrv->pCachedNext = NULL;
+	--numDrvCached;
 
-			if (numWritten)
-				++cntChildDrawn;
+	return pDrv;
+}
 
-			if (cntChildDrawn < 11)
-				continue;
+static void driverJoin(DriverInternal *pDrv)
+{
+#if CONFIG_PROC_HAVE_PTHREAD
+	pthread_join(pDrv->thread, NULL);
+#else
+	pDrv->pThread->join();
+	delete pDrv->pThread;
+#endif
+	delete pDrv;
+}
 
-			for (n = 0; n < numIndent; ++n)
-				dInfo(" ");
+// Process has left and the driver isn't driving anymore
+static void driverRetire(DriverInternal *pDrv)
+{
+	if (pDrv->reusable && driverCachedPush(pDrv))
+		return;
 
-			dInfo("..\r\n");
+	{
+		Guard lock(mtxDrvCached);
 
-			break;
-		}
+		pDrv->pCachedNext = pDrvExitFirst;
+		pDrvExitFirst = pDrv;
 	}
 
-	return (size_t)(pBuf - pBufStart);
-}
+	Guard lock(pDrv->mtxPark);
 
-void Processing::undrivenSet(Processing *pChild)
-{
-	pChild->mStatDrv |= PsbDrvUndriven;
+	pDrv->exit = true;
+	pDrv->cvPark.notify_one();
 }
 
-void Processing::destroy(Processing *pChild)
+// Threads still running are kept unless all are requested
+static void driversExitJoin(bool all)
 {
-	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
-	procId(childId, childId + sizeof(childId), pChild);
+	DriverInternal *pDrv, *pDrvNext, *pJoinFirst = NULL;
+	DriverInternal **ppDrv;
 
-	coreLog("child %s destroy()", childId);
+	{
+		Guard lock(mtxDrvCached);
 
-	if (pChild->mNumChildren)
-		errLog(-1, "destroying child with grand children");
+		ppDrv = &pDrvExitFirst;
+		while (*ppDrv)
+		{
+			pDrv = *ppDrv;
 
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-	if (pChild->mpChildList)
-	{
-		coreLog("child %s deleting child list", childId);
-		delete[] pChild->mpChildList;
-		pChild->mpChildList = NULL;
-		coreLog("child %s deleting child list: done", childId);
+			if (!all && !pDrv->exited)
+			{
+				ppDrv = &pDrv->pCachedNext;
+				continue;
+			}
+
+			*ppDrv = pDrv->pCachedNext;
+			pDrv->pCachedNext = pJoinFirst;
+			pJoinFirst = pDrv;
+		}
 	}
-#endif
-#if CONFIG_PROC_HAVE_DRIVERS
-	if (pChild->mpDriver)
+
+	for (pDrv = pJoinFirst; pDrv; pDrv = pDrvNext)
 	{
-		coreLog("driver cleanup");
-		pFctDriverInternalCleanUp(pChild->mpDriver);
-		pChild->mpDriver = NULL;
-		coreLog("driver cleanup: done");
+		pDrvNext = pDrv->pCachedNext;
+		driverJoin(pDrv);
 	}
-#endif
-	coreLog("child %s delete()", childId);
-	delete pChild;
-	coreLog("child %s delete(): done", childId);
-
-	coreLog("child %s destroy(): done", childId);
 }
 
-void Processing::applicationClose()
+static void driversStop()
 {
-	coreLog("closing application");
+	DriverInternal *pDrv;
 
-#if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
-	coreLog("executing global destructors");
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-	list<FuncGlobDestruct>::iterator iter = globalDestructors.begin();
+	// Drivers released while driving retire on their own
+	{
+		unique_lock<mutex> lock(mtxDrvCached);
 
-	while (iter != globalDestructors.end())
-		(*iter++)();
+		while (numDrvReleasing)
+			cvDrvRetired.wait(lock);
+	}
 
-	globalDestructors.clear();
-#else
-	FuncGlobDestruct *pGlobDestrListElem = pGlobalDestructors;
+	while (1)
+	{
+		pDrv = driverCachedPop();
+		if (!pDrv)
+			break;
 
-	while (pGlobDestrListElem && *pGlobDestrListElem)
-		(*pGlobDestrListElem++)();
+		{
+			Guard lock(pDrv->mtxPark);
 
-	if (pGlobalDestructors)
-		delete[] pGlobalDestructors;
-#endif
-	coreLog("executing global destructors: done");
-#else
-	coreLog("global destructors disabled");
-#endif
+			pDrv->exit = true;
+			pDrv->cvPark.notify_one();
+		}
 
-	coreLog("closing application: done");
+		driverJoin(pDrv);
+	}
+
+	driversExitJoin(true);
 }
+#endif
 
-void Processing::globalDestructorRegister(FuncGlobDestruct globDestr)
+#if CONFIG_PROC_HAVE_PTHREAD
+/*
+ * Settings are applied by the new thread itself.
+ * Failures are not fatal. Real time policies and
+ * memory policies may require privileges
+ *
+ * Literature
+ * - https://man7.org/linux/man-pages/man3/pthread_setaffinity_np.3.html
+ * - https://man7.org/linux/man-pages/man7/sched.7.html
+ * - https://man7.org/linux/man-pages/man2/set_mempolicy.2.html
+ */
+static void driverConfigApply(DriverInternal *pDrv)
 {
-#if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
-	coreLog("");
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-	globalDestructors.push_front(globDestr);
-	globalDestructors.unique();
-	coreLog(": done");
-#else
-	FuncGlobDestruct *pGlobDestrListElem = NULL;
+	const ConfigDriver *pConfig = &pDrv->config;
+	int res;
 
-	if (!pGlobalDestructors)
+	res = prctl(PR_SET_NAME, pDrv->name, 0, 0, 0);
+	if (res < 0)
+		wrnLog("could not set driver name via prctl()");
+
+	if (pConfig->maskCpu)
 	{
-		size_t numDestrElements = CONFIG_PROC_NUM_MAX_GLOBAL_DESTRUCTORS + 1;
+		cpu_set_t set;
 
-		pGlobalDestructors = new dNoThrow FuncGlobDestruct[numDestrElements];
-		if (!pGlobalDestructors)
+		CPU_ZERO(&set);
+
+		for (int i = 0; i < 64; ++i)
 		{
-			errLog(-1, "could not allocate global destructor list");
-			return;
+			if (pConfig->maskCpu >> i & 1)
+				CPU_SET(i, &set);
 		}
 
-		pGlobDestrListElem = pGlobalDestructors;
-		for (size_t i = 0; i < numDestrElements; ++i)
-			*pGlobDestrListElem++ = NULL;
+		res = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if (res)
+			wrnLog("could not set CPU affinity of driver: %s", strerror(res));
 	}
 
-	pGlobDestrListElem = pGlobalDestructors;
-	for (size_t i = 0; i < CONFIG_PROC_NUM_MAX_GLOBAL_DESTRUCTORS; ++i)
+	if (pConfig->policy != PolicyInherit)
 	{
-		if (!*pGlobDestrListElem)
-		{
-			*pGlobDestrListElem = globDestr;
-			coreLog(": done");
-			return;
-		}
+		struct sched_param param;
+		int policy = SCHED_OTHER;
 
-		++pGlobDestrListElem;
+		memset(&param, 0, sizeof(param));
+
+		if (pConfig->policy == PolicyFifo)
+			policy = SCHED_FIFO;
+		else if (pConfig->policy == PolicyRoundRobin)
+			policy = SCHED_RR;
+
+		if (policy != SCHED_OTHER)
+			param.sched_priority = pConfig->priority;
+
+		res = pthread_setschedparam(pthread_self(), policy, &param);
+		if (res)
+			wrnLog("could not set scheduling policy of driver: %s", strerror(res));
 	}
 
-	errLog(-2, "could not register global destructor. no free slot available");
-#endif
-#else
-	(void)globDestr;
-	errLog(-1, "can't register global destructor. function disabled");
-#endif
+	if (pConfig->idNodeNuma >= 0 && pConfig->idNodeNuma < 64)
+	{
+		unsigned long mask = 1UL << pConfig->idNodeNuma;
+		long resSys;
+
+		resSys = syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8 + 1);
+		if (resSys < 0)
+			wrnLog("could not set NUMA node of driver: %s", strerror(errno));
+	}
 }
 
-#if !CONFIG_PROC_HAVE_LIB_STD_C
-const char *Processing::strrchr(const char *x, char y)
+#endif
+
+#if CONFIG_PROC_HAVE_DRIVERS
+static void driverInternalLoop(DriverInternal *pDrv)
 {
-	if (!x)
-		return NULL;
+	unique_lock<mutex> lock(pDrv->mtxPark);
 
-	for (; *x; ++x)
+	while (pDrv->pProc)
 	{
-		if (*x == y)
-			return x;
+		lock.unlock();
+#if CONFIG_PROC_HAVE_PTHREAD
+		driverConfigApply(pDrv);
+#endif
+		pDrv->pFctDrive(pDrv->pProc);
+
+		// Process is not touched anymore
+		lock.lock();
+		pDrv->pProc = NULL;
+		pDrv->driving = false;
+
+		if (pDrv->released)
+		{
+			lock.unlock();
+			driverRetire(pDrv);
+
+			{
+				Guard lockCached(mtxDrvCached);
+				--numDrvReleasing;
+			}
+
+			cvDrvRetired.notify_all();
+			lock.lock();
+		}
+
+		while (!pDrv->pProc && !pDrv->exit)
+			pDrv->cvPark.wait(lock);
 	}
 
-	return NULL;
+	lock.unlock();
+
+	Guard lockCached(mtxDrvCached);
+	pDrv->exited = true;
 }
+#endif
 
-void *Processing::memcpy(void *to, const void *from, size_t cnt)
+#if CONFIG_PROC_HAVE_PTHREAD
+static void *driverInternalMain(void *pArg)
 {
-	const char *pFrom = (const char *)from;
-	char *pTo = (char *)to;
-
-	for (; cnt; --cnt)
-		*pTo++ = *pFrom++;
+	driverInternalLoop((DriverInternal *)pArg);
 
-	return to;
+	return NULL;
 }
 #endif
 
+#if CONFIG_PROC_HAVE_TRACE
+#define dTraceMask			(CONFIG_PROC_TRACE_NUM_EVENTS - 1)
+
+// Registry of all driver contexts for dumping
+static DriverContext *pCtxTraceFirst = NULL;
+static uint32_t idDriverNext = 0;
 #if CONFIG_PROC_HAVE_DRIVERS
-void Processing::sleepUsInternalDriveSet(size_t delayUs)
-{
-#if defined(__linux__) || defined(__FreeBSD__) || defined(_WIN32)
-	if (!delayUs)
-		wrnLog("Sleep time for internal drivers set to zero => Busy loop");
+static mutex mtxCtxTrace;
+#endif
 #endif
-	sleepInternalDriveUs = delayUs;
-}
 
-void Processing::sleepInternalDriveSet(chrono::microseconds delay)
+#if CONFIG_PROC_HAVE_WATCHDOG
+static const char *namesHook[] =
 {
-	sleepUsInternalDriveSet((size_t)delay.count());
-}
+	"initialize", "process", "shutdown"
+};
 
-void Processing::sleepInternalDriveSet(chrono::milliseconds delay)
-{
-	sleepUsInternalDriveSet((size_t)delay.count() * 1000);
-}
+#if CONFIG_PROC_HAVE_DRIVERS
+static atomic<uint32_t> budgetWatchdogUs(CONFIG_PROC_WATCHDOG_BUDGET_US);
 
-void Processing::numBurstInternalDriveSet(size_t numBurst)
+static thread *pThrWatchdog = NULL;
+static bool exitWatchdog = false;
+static mutex mtxWatchdog;
+static condition_variable cvWatchdog;
+
+/*
+ * Call of a thread checked by the watchdog thread. Children
+ * ticked in parallel run on their own workers and therefore
+ * don't hide each other. Listed on first use
+ */
+struct HookSlot
 {
-	if (!numBurst)
-		return;
+	HookSlot()
+		: pProc(NULL)
+		, tStartNs(0)
+		, tReportedNs(0)
+		, pNext(NULL)
+		, pPrev(NULL)
+		, listed(false)
+	{}
+
+	~HookSlot()
+	{
+		if (!listed)
+			return;
+
+		Guard lock(mtxWatchdog);
+
+		if (pPrev)
+			pPrev->pNext = pNext;
+		else
+			pSlotWdFirst = pNext;
+
+		if (pNext)
+			pNext->pPrev = pPrev;
+	}
+
+	atomic<Processing *> pProc;
+	atomic<uint64_t> tStartNs;
+	uint64_t tReportedNs;
+	HookSlot *pNext;
+	HookSlot *pPrev;
+	bool listed;
+
+	static HookSlot *pSlotWdFirst;
+};
+
+HookSlot *HookSlot::pSlotWdFirst = NULL;
+static thread_local HookSlot slotHook;
+#else
+static uint32_t budgetWatchdogUs = CONFIG_PROC_WATCHDOG_BUDGET_US;
+#endif
+#endif
+
+#if CONFIG_PROC_HAVE_PROFILING || CONFIG_PROC_HAVE_WATCHDOG
+// Call of initialize(), process() or shutdown()
+struct HookFrame
+{
+	uint64_t tStartNs;
+#if CONFIG_PROC_HAVE_WATCHDOG && CONFIG_PROC_HAVE_DRIVERS
+	// Interrupted call of the same thread
+	Processing *pProcOuter;
+	uint64_t tStartOuterNs;
+#endif
+};
+#endif
+
+#if CONFIG_PROC_HAVE_DRIVERS
+/*
+ * Readers of the process tree like processTreeStr() don't
+ * lock the child lists. Removed children are therefore
+ * destroyed after all readers active at removal time left.
+ * Each thread announces the epoch in which its outermost
+ * read started. Every retirement advances the epoch.
+ * Readers starting later never delay older retirements
+ *
+ * Literature
+ * - https://www.kernel.org/doc/html/latest/RCU/whatisRCU.html
+ * - https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf
+ */
+struct TreeSlot
+{
+	TreeSlot()
+		: epoch(0)
+		, depth(0)
+		, pNext(NULL)
+		, pPrev(NULL)
+		, listed(false)
+	{}
+
+	~TreeSlot();
+
+	// 0: Not reading
+	atomic<uint32_t> epoch;
+	uint32_t depth;
+	TreeSlot *pNext;
+	TreeSlot *pPrev;
+	bool listed;
+};
+
+static atomic<uint32_t> epochTree(1);
+static mutex mtxTreeSlots;
+static TreeSlot *pTreeSlotFirst = NULL;
+static thread_local TreeSlot slotTree;
+
+TreeSlot::~TreeSlot()
+{
+	if (!listed)
+		return;
+
+	Guard lock(mtxTreeSlots);
+
+	if (pPrev)
+		pPrev->pNext = pNext;
+	else
+		pTreeSlotFirst = pNext;
+
+	if (pNext)
+		pNext->pPrev = pPrev;
+}
+
+static void treeSlotList()
+{
+	Guard lock(mtxTreeSlots);
+
+	slotTree.pNext = pTreeSlotFirst;
+	if (pTreeSlotFirst)
+		pTreeSlotFirst->pPrev = &slotTree;
+	pTreeSlotFirst = &slotTree;
+
+	slotTree.listed = true;
+}
+
+// Return: Epoch of the retirement. Used after unlinking
+static uint32_t treeEpochAdvance()
+{
+	uint32_t epoch = epochTree.fetch_add(1) + 1;
+
+	if (!epoch)
+		epoch = epochTree.fetch_add(1) + 1;
+
+	return epoch;
+}
+
+// Return: True if a reader started before the epoch is still active
+static bool treeReadersBefore(uint32_t epoch)
+{
+	TreeSlot *pSlot;
+	uint32_t epochSlot;
+
+	Guard lock(mtxTreeSlots);
+
+	for (pSlot = pTreeSlotFirst; pSlot; pSlot = pSlot->pNext)
+	{
+		// Ordered with the announcement of the readers
+		epochSlot = pSlot->epoch.load();
+
+		if (epochSlot && (int32_t)(epochSlot - epoch) < 0)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Children ticked in parallel share the driver context
+ * of their parent. Timers and retired processes of the
+ * context are only locked while a fork is active
+ */
+struct CtxGuard
+{
+	CtxGuard(DriverContext *pCtx)
+		: pMtx(pCtx && pCtx->numForks ? &pCtx->mtxFork : NULL)
+	{
+		if (pMtx)
+			pMtx->lock();
+	}
+
+	~CtxGuard()
+	{
+		if (pMtx)
+			pMtx->unlock();
+	}
+
+	mutex *pMtx;
+};
+
+struct TreeReadGuard
+{
+	TreeReadGuard()
+	{
+		if (slotTree.depth++)
+			return;
+
+		if (!slotTree.listed)
+			treeSlotList();
+
+		// Announced before the first pointer is read
+		slotTree.epoch.exchange(epochTree.load());
+	}
+
+	~TreeReadGuard()
+	{
+		if (--slotTree.depth)
+			return;
+
+		slotTree.epoch.store(0, memory_order_release);
+	}
+};
+
+/*
+ * processInfo() is called by the driver of the process only.
+ * Renderers on other threads get the snapshot taken on the
+ * root tick of the context following their request
+ */
+static mutex mtxInfo;
+
+struct CtxTickGuard;
+static thread_local CtxTickGuard *pCtxTickFirst = NULL;
+
+// Contexts ticked by this thread right now
+struct CtxTickGuard
+{
+	CtxTickGuard(DriverContext *pCtxTick)
+		: pCtx(pCtxTick)
+		, pPrev(NULL)
+	{
+		if (!pCtx)
+			return;
+
+		pPrev = pCtxTickFirst;
+		pCtxTickFirst = this;
+	}
+
+	~CtxTickGuard()
+	{
+		if (pCtx)
+			pCtxTickFirst = pPrev;
+	}
+
+	static bool ticking(const DriverContext *pCtxFind)
+	{
+		const CtxTickGuard *pGuard = pCtxTickFirst;
+
+		for (; pGuard; pGuard = pGuard->pPrev)
+		{
+			if (pGuard->pCtx == pCtxFind)
+				return true;
+		}
+
+		return false;
+	}
+
+	DriverContext *pCtx;
+	CtxTickGuard *pPrev;
+};
+#endif
+
+#if CONFIG_PROC_HAVE_REGISTRY
+/*
+ * Registry of started processes. Hash chains by id, name
+ * and path. The chains are intrusive. No allocations per process
+ * - Writers are serialized by a mutex
+ * - Readers don't lock. Like tree walks they are protected
+ *   against destruction of processes by TreeReadGuard
+ * - Growing rewires the chains. Readers notice it with the
+ *   sequence counter and retry
+ * Paths are the names from the root separated by '/'.
+ * Names and paths don't need to be unique. The newest
+ * process is found first
+ */
+enum RegIndex
+{
+	RiId = 0,
+	RiName,
+	RiPath,
+	RiNum,
+};
+
+#define dFnvOffset		2166136261u
+#define dFnvPrime		16777619u
+
+struct Registry
+{
+	PtrProc *pBuckets[RiNum];
+	uint32_t mask;
+	uint32_t numProcs;
+};
+
+#if CONFIG_PROC_HAVE_DRIVERS
+static atomic<Registry *> pRegistry(NULL);
+static atomic<uint32_t> seqRegistry(0);
+static mutex mtxRegistry;
+static Registry *pRegistryRetired = NULL;
+static uint32_t epochRegistryRetired = 0;
+#else
+static Registry *pRegistry = NULL;
+#endif
+static uint32_t idNumNext = 1;
+
+static uint32_t hashAdd(uint32_t hash, const char *pStr, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		hash ^= (uint8_t)pStr[i];
+		hash *= dFnvPrime;
+	}
+
+	return hash;
+}
+
+static size_t strLen(const char *pStr)
+{
+	size_t len = 0;
+
+	if (!pStr)
+		return 0;
+
+	while (pStr[len])
+		++len;
+
+	return len;
+}
+
+static bool strEqual(const char *pStr1, const char *pStr2, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (pStr1[i] != pStr2[i])
+			return false;
+	}
+
+	return true;
+}
+
+static Registry *registryCreate(uint32_t numBuckets)
+{
+	Registry *pReg = new dNoThrow Registry;
+	size_t i, k;
+
+	if (!pReg)
+		return NULL;
+
+	for (i = 0; i < RiNum; ++i)
+	{
+		pReg->pBuckets[i] = new dNoThrow PtrProc[numBuckets];
+		if (pReg->pBuckets[i])
+			continue;
+
+		while (i)
+			delete[] pReg->pBuckets[--i];
+		delete pReg;
+
+		return NULL;
+	}
+
+	for (i = 0; i < RiNum; ++i)
+	{
+		for (k = 0; k < numBuckets; ++k)
+			pReg->pBuckets[i][k] = NULL;
+	}
+
+	pReg->mask = numBuckets - 1;
+	pReg->numProcs = 0;
+
+	return pReg;
+}
+
+static void registryDelete(Registry *pReg)
+{
+	if (!pReg)
+		return;
+
+	for (size_t i = 0; i < RiNum; ++i)
+		delete[] pReg->pBuckets[i];
+
+	delete pReg;
+}
+
+static void chainInsert(PtrProc *pHead, Processing *pProc,
+				PtrProc Processing::*pNext, PtrProc *Processing::*ppPrev)
+{
+	Processing *pFirst = *pHead;
+
+	pProc->*pNext = pFirst;
+	pProc->*ppPrev = pHead;
+
+	if (pFirst)
+		pFirst->*ppPrev = &(pProc->*pNext);
+
+	// Publish
+	*pHead = pProc;
+}
+
+static void chainRemove(Processing *pProc,
+				PtrProc Processing::*pNext, PtrProc *Processing::*ppPrev)
+{
+	Processing *pFollow = pProc->*pNext;
+
+	// Link of the process is kept for readers
+	*(pProc->*ppPrev) = pFollow;
+
+	if (pFollow)
+		pFollow->*ppPrev = pProc->*ppPrev;
+
+	pProc->*ppPrev = NULL;
+}
+
+// Processes still registered are not touched
+static void registryClear()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxRegistry);
+
+	registryDelete(pRegistryRetired);
+	pRegistryRetired = NULL;
+
+	registryDelete(pRegistry.exchange(NULL));
+#else
+	registryDelete(pRegistry);
+	pRegistry = NULL;
+#endif
+}
+#endif
+
+/*
+ * Tick source in milliseconds. For example a HAL tick.
+ * Wraps around. Extended to 64 bits here
+ */
+static FuncClockSource pFctClockSource = NULL;
+#if CONFIG_PROC_HAVE_DRIVERS
+static atomic<uint64_t> tSourceLastMs(0);
+#else
+static uint64_t tSourceLastMs = 0;
+#endif
+#if !CONFIG_PROC_HAVE_CHRONO
+static bool clockMissingLogged = false;
+#endif
+
+static uint64_t tickSourceMs()
+{
+	uint32_t tMs = pFctClockSource();
+	uint64_t tLastMs = tSourceLastMs;
+	uint64_t tNewMs;
+#if CONFIG_PROC_HAVE_DRIVERS
+	do
+	{
+#endif
+		tNewMs = (tLastMs & ~(uint64_t)0xFFFFFFFF) | tMs;
+
+		// Small steps back are reads of other drivers overtaken
+		if (tNewMs + 0x80000000 < tLastMs)
+			tNewMs += (uint64_t)1 << 32;
+
+		if (tNewMs <= tLastMs)
+			return tLastMs;
+#if CONFIG_PROC_HAVE_DRIVERS
+	} while (!tSourceLastMs.compare_exchange_weak(tLastMs, tNewMs));
+#else
+	tSourceLastMs = tNewMs;
+#endif
+	return tNewMs;
+}
+
+// Not cached. Used for durations
+static uint64_t tickNs()
+{
+	if (pFctClockSource)
+		return tickSourceMs() * 1000000;
+#if CONFIG_PROC_HAVE_CHRONO
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+	// Timeouts would never expire
+	if (!clockMissingLogged)
+	{
+		clockMissingLogged = true;
+		errLog(-1, "no clock. Set a tick source with Processing::clockSourceSet()");
+	}
+
+	return 0;
+#endif
+}
+
+/*
+ * Clock of the tree. Sampled at most once during the tick
+ * of the outermost root process of each thread and only
+ * when needed. Outside of ticks the clock is read directly
+ * - 0: Not ticking
+ * - 1: Ticking. Not sampled yet
+ */
+#if CONFIG_PROC_HAVE_DRIVERS
+static thread_local uint64_t tClockCachedNs = 0;
+static atomic<bool> clockVirtual(false);
+static atomic<uint64_t> tClockVirtualNs(0);
+#else
+static uint64_t tClockCachedNs = 0;
+static bool clockVirtual = false;
+static uint64_t tClockVirtualNs = 0;
+#endif
+
+struct ClockGuard
+{
+	ClockGuard(bool root)
+		: owner(root && !tClockCachedNs)
+	{
+		if (owner)
+			tClockCachedNs = 1;
+	}
+
+	~ClockGuard()
+	{
+		if (owner)
+			tClockCachedNs = 0;
+	}
+
+	bool owner;
+};
+
+#if CONFIG_PROC_HAVE_EPOLL
+static bool ctxEpollCreate(DriverContext *pCtx)
+{
+	struct epoll_event ev;
+	int fdEpoll, res;
+
+	fdEpoll = epoll_create1(EPOLL_CLOEXEC);
+	if (fdEpoll < 0)
+		return false;
+
+	pCtx->fdWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (pCtx->fdWakeup < 0)
+	{
+		::close(fdEpoll);
+		return false;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+
+	res = epoll_ctl(fdEpoll, EPOLL_CTL_ADD, pCtx->fdWakeup, &ev);
+	if (res < 0)
+	{
+		::close(pCtx->fdWakeup);
+		::close(fdEpoll);
+		pCtx->fdWakeup = -1;
+		return false;
+	}
+
+	pCtx->fdEpoll.store(fdEpoll, memory_order_release);
+
+	return true;
+}
+
+// Context must be locked. Return: Link to the registration or to NULL
+static FdRegistration **fdRegFind(DriverContext *pCtx, int fd)
+{
+	FdRegistration **ppReg = &pCtx->pFdRegFirst;
+
+	while (*ppReg && (*ppReg)->fd != fd)
+		ppReg = &(*ppReg)->pNext;
+
+	return ppReg;
+}
+
+// Context must be locked
+static void fdRegsRelease(DriverContext *pCtx, const Processing *pProc)
+{
+	FdRegistration **ppReg = &pCtx->pFdRegFirst;
+	FdRegistration *pReg;
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+
+	while (*ppReg)
+	{
+		pReg = *ppReg;
+
+		if (pReg->pProc != pProc)
+		{
+			ppReg = &pReg->pNext;
+			continue;
+		}
+
+		*ppReg = pReg->pNext;
+
+		// Fails if the descriptor has been closed already
+		(void)epoll_ctl(pCtx->fdEpoll, EPOLL_CTL_DEL, pReg->fd, &ev);
+		delete pReg;
+	}
+}
+#if CONFIG_PROC_HAVE_MIGRATION
+// Registrations of the process follow it to the epoll instance of pCtx
+static void fdRegsMove(DriverContext *pCtxOld, DriverContext *pCtx, Processing *pProc)
+{
+	FdRegistration **ppReg, *pReg, *pMovedFirst = NULL;
+	struct epoll_event ev;
+	int res;
+
+	if (!pCtxOld)
+		return;
+
+	memset(&ev, 0, sizeof(ev));
+
+	{
+		CtxGuard lock(pCtxOld);
+
+		ppReg = &pCtxOld->pFdRegFirst;
+		while (*ppReg)
+		{
+			pReg = *ppReg;
+
+			if (pReg->pProc != pProc)
+			{
+				ppReg = &pReg->pNext;
+				continue;
+			}
+
+			*ppReg = pReg->pNext;
+			(void)epoll_ctl(pCtxOld->fdEpoll, EPOLL_CTL_DEL, pReg->fd, &ev);
+
+			pReg->pNext = pMovedFirst;
+			pMovedFirst = pReg;
+		}
+	}
+
+	if (!pMovedFirst)
+		return;
+
+	bool epollOk;
+	{
+		Guard lock(pCtx->mtxWait);
+		epollOk = pCtx->fdEpoll >= 0 || ctxEpollCreate(pCtx);
+	}
+
+	CtxGuard lock(pCtx);
+
+	while (pMovedFirst)
+	{
+		pReg = pMovedFirst;
+		pMovedFirst = pReg->pNext;
+
+		ev.events = pReg->events;
+		ev.data.ptr = pProc;
+
+		res = -1;
+		if (epollOk)
+		{
+			res = epoll_ctl(pCtx->fdEpoll, EPOLL_CTL_ADD, pReg->fd, &ev);
+			if (res < 0 && errno == EEXIST)
+				res = epoll_ctl(pCtx->fdEpoll, EPOLL_CTL_MOD, pReg->fd, &ev);
+		}
+
+		if (res < 0)
+		{
+			wrnLog("could not move registration of file descriptor %d", pReg->fd);
+			delete pReg;
+			continue;
+		}
+
+		pReg->pNext = pCtx->pFdRegFirst;
+		pCtx->pFdRegFirst = pReg;
+	}
+}
+#endif
+#endif
+
+uint8_t Processing::showAddressInId = CONFIG_PROC_SHOW_ADDRESS_IN_ID;
+uint8_t Processing::disableTreeDefault = CONFIG_PROC_DISABLE_TREE_DEFAULT;
+#if CONFIG_PROC_HAVE_POOLS
+FuncProcAlloc Processing::pFctProcAlloc = poolAlloc;
+FuncProcFree Processing::pFctProcFree = poolFree;
+#else
+FuncProcAlloc Processing::pFctProcAlloc = heapAlloc;
+FuncProcFree Processing::pFctProcFree = heapFree;
+#endif
+
+#if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+list<FuncGlobDestruct> Processing::globalDestructors;
+#else
+FuncGlobDestruct *Processing::pGlobalDestructors = NULL;
+#endif
+#endif
+
+#if CONFIG_PROC_HAVE_DRIVERS
+size_t Processing::sleepInternalDriveUs = 2000;
+size_t Processing::sleepReactiveDriveUs = CONFIG_PROC_SLEEP_US_REACTIVE_DEFAULT;
+size_t Processing::numBurstInternalDrive = 13;
+FuncInternalDrive Processing::pFctInternalDrive = Processing::internalDrive;
+FuncDriverInternalCreate Processing::pFctDriverInternalCreate = Processing::driverInternalCreate;
+FuncDriverInternalCreateOpaque Processing::pFctDriverInternalCreateOpaque = NULL;
+FuncDriverInternalCleanUp Processing::pFctDriverInternalCleanUp = Processing::driverInternalCleanUp;
+FuncDriverInternalWakeup Processing::pFctDriverInternalWakeup = NULL;
+FuncForkJoin Processing::pFctForkJoin = NULL;
+#endif
+#if CONFIG_PROC_HAVE_MIGRATION
+uint16_t Processing::migrationHotUs = CONFIG_PROC_MIGRATION_HOT_US;
+uint16_t Processing::migrationColdUs = CONFIG_PROC_MIGRATION_COLD_US;
+#endif
+
+/* Literature
+ * - http://man7.org/linux/man-pages/man5/proc.5.html
+ * - https://stackoverflow.com/questions/6261201/how-to-find-memory-leak-in-a-c-code-project
+ */
+
+// This area is used by the client
+
+/*
+ * Return: True if work has been done in the tree
+ * - Abstract state or mState changed
+ * - Child finished or removed
+ * - Woken up, file descriptor got ready
+ * - Process called workDoneSet()
+ */
+bool Processing::treeTick()
+{
+	// No need to lock child list here
+
+	Processing *pChild = NULL;
+	Success sSuccess;
+	bool worked = false;
+	bool forked = false;
+	uint8_t statDrv, stateAbstract, stateAbstractOld, stateOld;
+#if CONFIG_PROC_HAVE_PROFILING || CONFIG_PROC_HAVE_WATCHDOG
+	HookFrame frameHook;
+#endif
+	// Root of the tree is never started
+	DriverContext *pCtx = ctxDriverGet();
+
+	bool root = pCtx && pCtx->pRoot == this;
+	ClockGuard clockTick(root);
+#if CONFIG_PROC_HAVE_DRIVERS
+	CtxTickGuard ctxTick(root ? pCtx : NULL);
+#endif
+
+	if (root)
+	{
+		if (pCtx->pWakeFirst)
+			wakeQueueProcess(pCtx);
+
+#if CONFIG_PROC_HAVE_DRIVERS
+		if (pCtx->pRetiredFirst || pCtx->pCtxRetiredFirst)
+			retiredDestroy(pCtx, false);
+
+		if (pCtx->infoReq.load(memory_order_relaxed))
+		{
+			pCtx->infoReq.store(false, memory_order_relaxed);
+			infoSnapshotsTake(pCtx);
+		}
+#endif
+
+		if (pCtx->wheel.numTimers)
+			tmrAdvance(pCtx, clockMs());
+	}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	if (pFctForkJoin && mStatSched & PsbSchedParallelChildren)
+		forked = childrenParallelTick(worked);
+#endif
+	// Only runnable children are visited
+	pChild = mpActiveFirst;
+	while (pChild)
+	{
+		// Ticked in parallel already
+		if (forked && pChild->mStatSched & PsbSchedParallel)
+		{
+			pChild = pChild->mpActiveNext;
+			continue;
+		}
+
+		pChild = childWeightedTick(pChild, worked);
+	}
+
+	// Only after this point children can be created or destroyed
+	// and therefore added or removed from the child list
+
+	statDrv = dLoadAcq(mStatDrv);
+
+	if (mppTmrPrev || statDrv & PsbDrvIdle)
+	{
+		// Sleeping or idle
+		if (!mWakeupReq)
+			return worked;
+
+		if (mppTmrPrev)
+		{
+#if CONFIG_PROC_HAVE_DRIVERS
+			CtxGuard lock(pCtx);
+#endif
+			tmrRemove(this);
+		}
+
+		dClearRlx(mStatDrv, PsbDrvIdle);
+		mWakeupReq = false;
+		worked = true;
+	}
+
+	if (statDrv & PsbDrvFdEvent)
+		worked = true;
+#if CONFIG_PROC_HAVE_PROFILING
+	profileTick();
+#endif
+	while (1)
+	{
+		stateAbstractOld = dLoadRlx(mStateAbstract);
+		stateAbstract = stateAbstractOld;
+		stateOld = mState;
+
+		switch (stateAbstractOld)
+		{
+		case PsExistent:
+
+#if CONFIG_PROC_HAVE_DRIVERS && !CONFIG_PROC_HAVE_PTHREAD
+// cpp -dM /dev/null
+#if defined(CONFIG_PROC_TITLE_NEW_DRIVER)
+			// Only for worker threads
+			if (mDriver == DrivenByNewInternalDriver)
+			{
+				char buf[32];
+				char *pBuf = buf;
+				char *pBufEnd = pBuf + sizeof(buf);
+
+				dInfo("%p", (const void *)this);
+#if defined(__linux__)
+				int res;
+				res = prctl(PR_SET_NAME, buf, 0, 0, 0);
+				if (res < 0)
+					procWrnLog("could not set driver name via prctl()");
+#elif defined(__FreeBSD__)
+				setproctitle("%s", buf);
+#endif
+			}
+#endif
+#endif
+			if (dLoadAcq(mStatParent) & PsbParCanceled)
+			{
+				procCoreLog("process canceled during state existent");
+				stateAbstract = PsFinishedPrepare;
+				break;
+			}
+
+			procCoreLog("initializing()");
+			stateAbstract = PsInitializing;
+
+			break;
+		case PsInitializing:
+
+			if (dLoadAcq(mStatParent) & PsbParCanceled)
+			{
+				procCoreLog("process canceled during initializing");
+				procCoreLog("downShutting()");
+				stateAbstract = PsDownShutting;
+				break;
+			}
+
+			dHookEnter();
+			sSuccess = initialize(); // child list may be changed here
+			dHookLeave(PpInit);
+
+			if (sSuccess == Pending)
+				break;
+
+			if (sSuccess != Positive)
+			{
+				dStoreRel(mSuccess, sSuccess);
+				successCount();
+				procCoreLog("initializing(): failed. success = %d", int(sSuccess));
+				procCoreLog("downShutting()");
+				stateAbstract = PsDownShutting;
+				break;
+			}
+
+			procCoreLog("initializing(): done");
+			dOrRel(mStatDrv, PsbDrvInitDone);
+
+			procCoreLog("processing()");
+			stateAbstract = PsProcessing;
+
+			break;
+		case PsProcessing:
+
+			if (dLoadAcq(mStatParent) & PsbParCanceled)
+			{
+				procCoreLog("process canceled during processing");
+				procCoreLog("downShutting()");
+				stateAbstract = PsDownShutting;
+				break;
+			}
+
+			dHookEnter();
+			sSuccess = process(); // child list may be changed here
+			dHookLeave(PpProcess);
+
+			if (sSuccess == Pending)
+				break;
+
+			dStoreRel(mSuccess, sSuccess);
+			successCount();
+
+			procCoreLog("processing(): done. success = %d", int(sSuccess));
+			dOrRel(mStatDrv, PsbDrvProcessDone);
+
+			procCoreLog("downShutting()");
+			stateAbstract = PsDownShutting;
+
+			break;
+		case PsDownShutting:
+
+			dHookEnter();
+			sSuccess = shutdown(); // child list may be changed here
+			dHookLeave(PpShutdown);
+
+			if (sSuccess == Pending)
+				break;
+
+			procCoreLog("downShutting(): done");
+			dOrRel(mStatDrv, PsbDrvShutdownDone);
+
+			stateAbstract = PsChildrenUnusedSet;
+
+			break;
+		case PsChildrenUnusedSet:
+
+			procCoreLog("marking children as unused");
+			pChild = mpChildFirst;
+			for (; pChild; pChild = pChild->mpSiblingNext)
+			{
+				if (mStatSched & PsbSchedTeardownBulk)
+					dOrRlx(pChild->mStatSched, PsbSchedTeardownBulk);
+
+				pChild->unusedMark();
+			}
+			procCoreLog("marking children as unused: done");
+
+			stateAbstract = PsFinishedPrepare;
+
+			break;
+		case PsFinishedPrepare:
+
+			procCoreLog("preparing finish");
+
+			if (dLoadAcq(mStatParent) & PsbParWhenFinishedUnused)
+			{
+				procCoreLog("set process as unused when finished");
+				unusedMark();
+			}
+
+			procCoreLog("preparing finish: done -> finished");
+
+			stateAbstract = PsFinished;
+
+			break;
+		case PsFinished:
+
+			break;
+		default:
+			break;
+		}
+
+		if (dLoadRlx(mStatDrv) & PsbDrvWorkDone)
+		{
+			dClearRlx(mStatDrv, PsbDrvWorkDone);
+			worked = true;
+		}
+
+		if (mState != stateOld)
+			worked = true;
+
+		if (stateAbstract == stateAbstractOld)
+			break;
+
+		dStoreRel(mStateAbstract, stateAbstract);
+#if CONFIG_PROC_HAVE_TRACE
+		traceAdd(TeStateAbstract, this, stateAbstractOld, stateAbstract, NULL);
+#endif
+		worked = true;
+
+		// Bulk teardown. Next shutdown state right away.
+		// Bounded by the number of these states
+		if (!(mStatSched & PsbSchedTeardownBulk) ||
+				stateAbstract < PsDownShutting ||
+				stateAbstract == PsFinished)
+			break;
+
+		// Went to sleep or idle during shutdown()
+		if (mppTmrPrev || dLoadAcq(mStatDrv) & PsbDrvIdle)
+			break;
+	}
+
+	return worked;
+}
+
+bool Processing::progress() const
+{
+	return dLoadAcq(mStateAbstract) != PsFinished || mNumChildren;
+}
+
+Success Processing::success() const
+{
+	return dLoadAcq(mSuccess);
+}
+
+void Processing::unusedSet()
+{
+	uint8_t flags = PsbParCanceled | PsbParUnused;
+	dOrRel(mStatParent, flags);
+	successCount();
+
+	wakeup();
+}
+
+void Processing::procTreeDisplaySet(bool display)
+{
+	if (display)
+		dClearRlx(mStatDrv, PsbDrvPrTreeDisable);
+	else
+		dOrRlx(mStatDrv, PsbDrvPrTreeDisable);
+}
+
+/*
+ * Parallel safe processes share no data with their siblings.
+ * When a parent has several of them they are ticked together
+ * on the workers set with forkJoinSet(). The parent continues
+ * once all of them have been ticked. Their subtrees must not
+ * access the parent or siblings directly
+ */
+void Processing::parallelSet(bool parallel)
+{
+	if (!parallel)
+	{
+		dClearRlx(mStatSched, PsbSchedParallel);
+		return;
+	}
+
+	dOrRlx(mStatSched, PsbSchedParallel);
+
+	if (mpParent)
+		dOrRlx(mpParent->mStatSched, PsbSchedParallelChildren);
+}
+
+/*
+ * Weighted children are ticked up to weight times per tick of
+ * their parent as long as they are runnable. Siblings are still
+ * ticked at least once per pass, so they can't starve.
+ * After a wakeup weighted children are ticked first.
+ * Range: 1 .. 16. Default: 1
+ */
+void Processing::weightSet(uint8_t weight)
+{
+	if (!weight)
+		weight = 1;
+
+	if (weight > dWeightMax)
+		weight = dWeightMax;
+
+	uint8_t bitsWeight = (uint8_t)((weight - 1) << dWeightShift);
+	uint8_t stat = dLoadRlx(mStatSched);
+	uint8_t statNew;
+
+	// Other bits are set concurrently by children and drivers
+#if CONFIG_PROC_HAVE_DRIVERS
+	do
+	{
+#endif
+		statNew = (uint8_t)((stat & ~PsbSchedWeight) | bitsWeight);
+#if CONFIG_PROC_HAVE_DRIVERS
+	} while (!mStatSched.compare_exchange_weak(stat, statNew,
+					memory_order_relaxed));
+#else
+	mStatSched = statNew;
+#endif
+}
+
+uint8_t Processing::weight() const
+{
+	return ((mStatSched & PsbSchedWeight) >> dWeightShift) + 1;
+}
+
+/*
+ * In bulk teardown a canceled process passes through its
+ * shutdown states within a single tick. Its children are
+ * marked unused at once and inherit the mode. They pass
+ * through their shutdown states in the next tick, children
+ * on other drivers concurrently on their own threads.
+ * Waiting happens only where shutdown() returns Pending
+ */
+void Processing::teardownBulkSet(bool bulk)
+{
+	if (bulk)
+		dOrRlx(mStatSched, PsbSchedTeardownBulk);
+	else
+		dClearRlx(mStatSched, PsbSchedTeardownBulk);
+}
+
+#if CONFIG_PROC_HAVE_MIGRATION
+/*
+ * Migratable processes are moved between drivers at runtime
+ * depending on their average tick duration
+ * - Hot children driven by their parent get an own driver
+ * - Cold children on an own driver are driven by their parent again
+ * Only leafs in state processing which never registered
+ * file descriptors are moved
+ */
+void Processing::migrationSet(bool migratable)
+{
+	if (migratable)
+		mStatMigr |= PsbMigrEnabled;
+	else
+		mStatMigr &= ~PsbMigrEnabled;
+}
+#endif
+
+void Processing::argSet(void *pArg)
+{
+	mpArg = pArg;
+}
+
+/*
+ * Reactive drivers park up to sleepReactiveDriveUs
+ * instead of sleepInternalDriveUs. All processes of
+ * the driver must therefore wake it up via
+ * - Registered file descriptors: fdEventsAdd()
+ * - Timeouts: timeoutWakeupSet() or sleepSet()
+ * - Other drivers: wakeup()
+ * Can be set before the process is started
+ */
+void Processing::reactiveSet(bool reactive)
+{
+	DriverContext *pCtx = ctxDriverGet();
+
+	if (!pCtx)
+		return;
+
+	pCtx->reactive = reactive;
+}
+
+/*
+ * Bounds of parking for the driver of this process.
+ * Internal drivers tick without pause while work is done,
+ * then yield, then park minUs. Parking is doubled on every
+ * idle tick up to maxUs. maxUs = 0: sleepUsInternalDriveSet()
+ * or sleepUsReactiveDriveSet() is used
+ */
+void Processing::driveLatencySet(uint32_t minUs, uint32_t maxUs)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	DriverContext *pCtx = ctxDriverGet();
+
+	if (!pCtx)
+		return;
+
+	pCtx->latencyMinUs = minUs;
+	pCtx->latencyMaxUs = maxUs;
+#else
+	(void)minUs;
+	(void)maxUs;
+#endif
+}
+
+/*
+ * Ends sleeping of this process and wakes up its driver.
+ * Can be called from any driver. A migration may replace
+ * the context concurrently. The old one is retired and
+ * stays valid until all readers left
+ */
+void Processing::wakeup()
+{
+	mWakeupReq = true;
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	DriverContext *pCtx = mpCtxDriver;
+
+	if (!pCtx)
+		return;
+
+	// Shared context: Driven by the parent
+	if (pCtx->pRoot != this && dLoadAcq(mStatParent) & PsbParStarted)
+		wakeQueueAdd(pCtx, this);
+
+	ctxDriverWake(pCtx);
+}
+
+// Driver of the context leaves parking. No process is woken up
+void Processing::ctxDriverWake(DriverContext *pCtx)
+{
+#if !CONFIG_PROC_HAVE_EPOLL && !CONFIG_PROC_HAVE_DRIVERS
+	(void)pCtx;
+#endif
+#if CONFIG_PROC_HAVE_EPOLL
+	if (pCtx->fdEpoll.load(memory_order_acquire) >= 0)
+	{
+		uint64_t val = 1;
+		ssize_t res = ::write(pCtx->fdWakeup, &val, sizeof(val));
+		(void)res;
+	}
+#endif
+#if CONFIG_PROC_HAVE_DRIVERS
+	// Parker checks the flag under the lock before waiting
+	{
+		Guard lock(pCtx->mtxWait);
+		pCtx->wakeupPending = true;
+	}
+
+	pCtx->cvWait.notify_one();
+
+	if (pFctDriverInternalWakeup)
+		pFctDriverInternalWakeup(pCtx->pRoot);
+#endif
+}
+
+/*
+ * Used by external drivers instead of sleeping.
+ * Blocks until a registered file descriptor is ready,
+ * the earliest wakeup timeout expired, wakeup() has
+ * been called or tmoMs elapsed.
+ * Without drivers this function returns immediately
+ */
+void Processing::eventsWait(uint32_t tmoMs)
+{
+	ctxDriverWait(ctxDriverGet(), (size_t)tmoMs * 1000);
+}
+
+bool Processing::initDone() const		{ return dLoadAcq(mStatDrv) & PsbDrvInitDone;	}
+bool Processing::processDone() const	{ return dLoadAcq(mStatDrv) & PsbDrvProcessDone;	}
+bool Processing::shutdownDone() const	{ return dLoadAcq(mStatDrv) & PsbDrvShutdownDone;	}
+
+size_t Processing::processTreeStr(char *pBuf, char *pBufEnd, bool detailed, bool colored)
+{
+	Processing *pChild = NULL;
+	char bufInfo[CONFIG_PROC_INFO_BUFFER_SIZE];
+	const char *pBufStart = pBuf;
+	const char *pBufLineStart;
+	char *pBufIter;
+	uint16_t numIndent;
+	int8_t n, lastChildInfoLine;
+	int8_t cntChildDrawn;
+	size_t numWritten;
+
+	if (dLoadRlx(mStatDrv) & PsbDrvPrTreeDisable)
+		return 0;
+
+	if (!pBuf || !(pBufEnd - pBuf))
+		return 0;
+
+	for (n = 0; n < 2 * mLevelTree; ++n)
+		dInfo(" ");
+
+	Success success = dLoadAcq(mSuccess);
+
+	if (success == Pending)
+		dInfo("-");
+	else if (success == Positive)
+		dInfo("+");
+	else
+		dInfo("x");
+
+	dInfo(" ");
+
+	if (mDriver == DrivenByExternalDriver)
+	{
+#if CONFIG_PROC_USE_DRIVER_COLOR
+		if (colored)
+			dInfo("\033[38;5;135m");
+		else
+#endif
+			dInfo("### ");
+	}
+
+#if CONFIG_PROC_USE_DRIVER_COLOR
+	if (colored && !mLevelDriver)
+		dInfo("\033[38;5;40m");
+#endif
+
+	if (mDriver == DrivenByNewInternalDriver)
+	{
+#if CONFIG_PROC_USE_DRIVER_COLOR
+		if (colored)
+			dInfo("\033[38;5;81m");
+		else
+#endif
+			dInfo("*** ");
+	}
+
+	pBuf += procId(pBuf, pBufEnd, this);
+	dInfo("()");
+
+	if (weight() > 1)
+		dInfo(" w%u", weight());
+#if CONFIG_PROC_HAVE_REGISTRY
+	if (mIdNum)
+		dInfo(" #%u", mIdNum);
+#endif
+	dInfo("\r\n");
+
+#if CONFIG_PROC_USE_DRIVER_COLOR
+	if (colored)
+		dInfo("\033[37m");
+#endif
+	numIndent = 2 * mLevelTree + 2;
+
+	if (detailed && dLoadAcq(mStateAbstract) != PsFinished)
+	{
+		bufInfo[0] = 0;
+		infoGet(bufInfo, bufInfo + sizeof(bufInfo));
+		bufInfo[sizeof(bufInfo) - 1] = 0;
+
+		pBufLineStart = pBufIter = bufInfo;
+		lastChildInfoLine = 0;
+
+		while (1)
+		{
+			if (pBufIter >= bufInfo + sizeof(bufInfo))
+				break;
+
+			if (!bufInfo[0])
+				break;
+
+			if (*pBufIter && *pBufIter != '\n')
+			{
+				++pBufIter;
+				continue;
+			}
+
+			if (!*pBufIter)
+			{
+				if (!*(pBufIter - 1)) // last line drawn already
+					break;
+
+				lastChildInfoLine = 1;
+			}
+
+			for (n = 0; n < numIndent; ++n)
+				dInfo(" ");
+
+			*pBufIter = 0; // terminate current line starting at pBufLineStart
+
+			dInfo("%s\r\n", pBufLineStart);
+
+			++pBufIter;
+			pBufLineStart = pBufIter;
+
+			if (lastChildInfoLine)
+				break;
+		}
+#if CONFIG_PROC_HAVE_PROFILING
+		for (n = 0; n < numIndent; ++n)
+			dInfo(" ");
+
+		pBuf += profileStr(pBuf, pBufEnd);
+		dInfo("\r\n");
+#endif
+	}
+
+	cntChildDrawn = 0;
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+	{
+		numWritten = pChild->processTreeStr(pBuf, pBufEnd, detailed, colored);
+
+		pBuf += numWritten;
+
+		if (numWritten)
+			++cntChildDrawn;
+
+		if (cntChildDrawn < 11)
+			continue;
+
+		for (n = 0; n < numIndent; ++n)
+			dInfo(" ");
+
+		dInfo("..\r\n");
+
+		break;
+	}
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+/*
+ * Processes of other drivers are shown with their latest
+ * snapshot. The next one is requested and taken by the
+ * driver of the context on its next root tick
+ */
+void Processing::infoGet(char *pBuf, char *pBufEnd)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	DriverContext *pCtx = dLoadAcq(mpCtxDriver);
+
+	if (pCtx && !CtxTickGuard::ticking(pCtx))
+	{
+		{
+			Guard lock(mtxInfo);
+
+			size_t lenBuf = (size_t)(pBufEnd - pBuf);
+
+			if (lenBuf > CONFIG_PROC_INFO_BUFFER_SIZE)
+				lenBuf = CONFIG_PROC_INFO_BUFFER_SIZE;
+
+			if (mpInfoSnap && lenBuf)
+				memcpy(pBuf, mpInfoSnap, lenBuf);
+		}
+
+		if (!pCtx->infoReq.exchange(true, memory_order_relaxed))
+			ctxDriverWake(pCtx);
+
+		return;
+	}
+#endif
+	processInfo(pBuf, pBufEnd);
+}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+// Used by the driver of the context at the start of its root tick
+void Processing::infoSnapshotsTake(DriverContext *pCtx)
+{
+	char bufInfo[CONFIG_PROC_INFO_BUFFER_SIZE];
+	Processing *pChild;
+	char *pSnap = mpInfoSnap;
+
+	if (dLoadRlx(mStateAbstract) != PsFinished)
+	{
+		bufInfo[0] = 0;
+		processInfo(bufInfo, bufInfo + sizeof(bufInfo));
+		bufInfo[sizeof(bufInfo) - 1] = 0;
+
+		// Only the driver sets the snapshot
+		if (!pSnap)
+			pSnap = new dNoThrow char[sizeof(bufInfo)];
+
+		if (pSnap)
+		{
+			Guard lock(mtxInfo);
+
+			memcpy(pSnap, bufInfo, sizeof(bufInfo));
+			mpInfoSnap = pSnap;
+		}
+	}
+
+	// Children with own drivers take their snapshots themselves
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+	{
+		if (dLoadRlx(pChild->mpCtxDriver) == pCtx)
+			pChild->infoSnapshotsTake(pCtx);
+	}
+}
+#endif
+
+#if CONFIG_PROC_HAVE_PROFILING
+/*
+ * Counters are cleared by the drivers of the processes.
+ * Until then they are shown as zero
+ */
+void Processing::profileReset()
+{
+	Processing *pChild;
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	DriverContext *pCtx = dLoadAcq(mpCtxDriver);
+
+	dStoreRel(mProf.resetReq, true);
+
+	if (pCtx && pCtx->pRoot == this)
+		dStoreRel(pCtx->profResetReq, true);
+
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+		pChild->profileReset();
+}
+
+// Durations in microseconds: sum/max
+size_t Processing::profileStr(char *pBuf, char *pBufEnd) const
+{
+	char *pBufStart = pBuf;
+	const ProcProfile &prof = mProf;
+	bool reset = dLoadAcq(prof.resetReq);
+	unsigned numTicks = reset ? 0 : dLoadRlx(prof.numTicks);
+	unsigned durMaxUs[3];
+	unsigned long long durSumUs[3];
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		durMaxUs[i] = reset ? 0 : dLoadRlx(prof.durMaxNs[i]) / 1000;
+		durSumUs[i] = reset ? 0 : dLoadRlx(prof.durSumNs[i]) / 1000;
+	}
+
+	dInfo("Ticks %u, init %llu/%u, process %llu/%u, shutdown %llu/%u us",
+			numTicks,
+			durSumUs[PpInit], durMaxUs[PpInit],
+			durSumUs[PpProcess], durMaxUs[PpProcess],
+			durSumUs[PpShutdown], durMaxUs[PpShutdown]);
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	const DriverContext *pCtx = dLoadAcq(mpCtxDriver);
+
+	if (!pCtx || pCtx->pRoot != this)
+		return (size_t)(pBuf - pBufStart);
+
+	reset = dLoadAcq(pCtx->profResetReq);
+
+	uint64_t durBusyNs = reset ? 0 : dLoadRlx(pCtx->durBusyNs);
+	uint64_t durNs = reset ? 0 : durBusyNs + dLoadRlx(pCtx->durIdleNs);
+	unsigned load = durNs ? (unsigned)(durBusyNs * 1000 / durNs) : 0;
+
+	dInfo(", load %u.%u %%", load / 10, load % 10);
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+// Processes with the most time spent in their functions
+size_t Processing::profileTopStr(char *pBuf, char *pBufEnd, size_t numTop)
+{
+	char *pBufStart = pBuf;
+	Processing *pTop[8];
+
+	if (numTop > sizeof(pTop) / sizeof(pTop[0]))
+		numTop = sizeof(pTop) / sizeof(pTop[0]);
+
+	for (size_t i = 0; i < numTop; ++i)
+		pTop[i] = NULL;
+#if CONFIG_PROC_HAVE_DRIVERS
+	// Collected processes must not be destroyed until rendered
+	TreeReadGuard guard;
+#endif
+	profileTopCollect(pTop, numTop);
+
+	for (size_t i = 0; i < numTop && pTop[i]; ++i)
+	{
+		pBuf += procId(pBuf, pBufEnd, pTop[i]);
+		dInfo("\n  ");
+		pBuf += pTop[i]->profileStr(pBuf, pBufEnd);
+		dInfo("\n");
+	}
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+void Processing::profileClear()
+{
+	dStoreRlx(mProf.numTicks, 0);
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		dStoreRlx(mProf.durMaxNs[i], 0);
+		dStoreRlx(mProf.durSumNs[i], 0);
+	}
+
+	// Readers see the cleared counters with the flag
+	dStoreRel(mProf.resetReq, false);
+}
+
+// Single writer. No read-modify-write needed
+void Processing::profileTick()
+{
+	if (dLoadAcq(mProf.resetReq))
+		profileClear();
+
+	dStoreRlx(mProf.numTicks, dLoadRlx(mProf.numTicks) + 1);
+}
+
+void Processing::profileAdd(uint8_t idx, uint64_t durNs)
+{
+	dStoreRlx(mProf.durSumNs[idx], dLoadRlx(mProf.durSumNs[idx]) + durNs);
+
+	if (durNs > dLoadRlx(mProf.durMaxNs[idx]))
+		dStoreRlx(mProf.durMaxNs[idx], durNs > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)durNs);
+}
+
+static uint64_t profileSumNs(const ProcProfile &prof)
+{
+	if (dLoadAcq(prof.resetReq))
+		return 0;
+
+	return dLoadRlx(prof.durSumNs[PpInit]) +
+			dLoadRlx(prof.durSumNs[PpProcess]) +
+			dLoadRlx(prof.durSumNs[PpShutdown]);
+}
+
+// Sorted insertion. Descending
+void Processing::profileTopCollect(Processing **pTop, size_t numTop)
+{
+	Processing *pChild, *pIns = this, *pTmp;
+	uint64_t durIns, durCmp;
+	size_t i;
+
+	durIns = profileSumNs(mProf);
+
+	for (i = 0; i < numTop; ++i)
+	{
+		if (!pTop[i])
+		{
+			pTop[i] = pIns;
+			break;
+		}
+
+		durCmp = profileSumNs(pTop[i]->mProf);
+
+		if (durIns <= durCmp)
+			continue;
+
+		pTmp = pTop[i];
+		pTop[i] = pIns;
+		pIns = pTmp;
+		durIns = durCmp;
+	}
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+		pChild->profileTopCollect(pTop, numTop);
+}
+#endif
+
+#if CONFIG_PROC_HAVE_PROFILING || CONFIG_PROC_HAVE_WATCHDOG
+#if CONFIG_PROC_HAVE_WATCHDOG && CONFIG_PROC_HAVE_DRIVERS
+void Processing::watchdogSlotList()
+{
+	Guard lock(mtxWatchdog);
+
+	slotHook.pNext = HookSlot::pSlotWdFirst;
+	if (HookSlot::pSlotWdFirst)
+		HookSlot::pSlotWdFirst->pPrev = &slotHook;
+	HookSlot::pSlotWdFirst = &slotHook;
+
+	slotHook.listed = true;
+
+	// Started with the first call
+	if (pThrWatchdog || exitWatchdog)
+		return;
+
+	pThrWatchdog = new dNoThrow thread(watchdogMain);
+	if (!pThrWatchdog)
+		wrnLog("could not create watchdog thread");
+}
+#endif
+
+/*
+ * Calls of initialize(), process() and shutdown().
+ * The watchdog thread sees the innermost call of each thread
+ */
+inline void Processing::hookEnter(HookFrame *pFrame)
+{
+	pFrame->tStartNs = tickNs();
+#if CONFIG_PROC_HAVE_WATCHDOG && CONFIG_PROC_HAVE_DRIVERS
+	if (!slotHook.listed)
+		watchdogSlotList();
+
+	pFrame->pProcOuter = slotHook.pProc.load(memory_order_relaxed);
+	pFrame->tStartOuterNs = slotHook.tStartNs.load(memory_order_relaxed);
+
+	slotHook.pProc.store(this, memory_order_release);
+	slotHook.tStartNs.store(pFrame->tStartNs, memory_order_release);
+#endif
+}
+
+inline void Processing::hookLeave(uint8_t idx, const HookFrame *pFrame)
+{
+	uint64_t durNs = tickNs() - pFrame->tStartNs;
+#if CONFIG_PROC_HAVE_WATCHDOG
+	uint32_t budgetUs = budgetWatchdogUs;
+#if CONFIG_PROC_HAVE_DRIVERS
+	slotHook.tStartNs.store(0, memory_order_relaxed);
+	slotHook.pProc.store(pFrame->pProcOuter, memory_order_release);
+	slotHook.tStartNs.store(pFrame->tStartOuterNs, memory_order_release);
+#endif
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+	profileAdd(idx, durNs);
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+	if (budgetUs && durNs > uint64_t(budgetUs) * 1000)
+		overrunAdd(idx, durNs, budgetUs);
+#else
+	(void)idx;
+	(void)durNs;
+#endif
+}
+#endif
+
+#if CONFIG_PROC_HAVE_WATCHDOG
+void Processing::overrunReset()
+{
+	Processing *pChild;
+
+	memset(&mOvr, 0, sizeof(mOvr));
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+		pChild->overrunReset();
+}
+
+// Histogram in multiples of the budget
+size_t Processing::overrunStr(char *pBuf, char *pBufEnd) const
+{
+	char *pBufStart = pBuf;
+
+	dInfo("Overruns %u, max %u us, x1/2/4/8/16/32+ ",
+			mOvr.numOverruns, mOvr.durMaxUs);
+
+	for (size_t i = 0; i < dNumOverrunBuckets; ++i)
+		dInfo("%s%u", i ? "/" : "", mOvr.numInBucket[i]);
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+// Processes of the subtree with overruns
+size_t Processing::overrunsStr(char *pBuf, char *pBufEnd)
+{
+	char *pBufStart = pBuf;
+	Processing *pChild;
+
+	if (mOvr.numOverruns)
+	{
+		pBuf += procId(pBuf, pBufEnd, this);
+		dInfo("\n  ");
+		pBuf += overrunStr(pBuf, pBufEnd);
+		dInfo("\n");
+	}
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+		pBuf += pChild->overrunsStr(pBuf, pBufEnd);
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+// Budget loaded once by the caller. It may be changed concurrently
+void Processing::overrunAdd(uint8_t idx, uint64_t durNs, uint32_t budgetUs)
+{
+	uint64_t durUs = durNs / 1000;
+	uint64_t ratio = durUs / budgetUs;
+	size_t i = 0;
+
+	for (; ratio > 1 && i < dNumOverrunBuckets - 1; ++i)
+		ratio >>= 1;
+
+	++mOvr.numOverruns;
+
+	if (mOvr.numInBucket[i] < 0xFFFF)
+		++mOvr.numInBucket[i];
+
+	if (durUs > mOvr.durMaxUs)
+		mOvr.durMaxUs = durUs > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)durUs;
+
+	procWrnLog("%s() blocked the driver for %llu us. Budget %u us",
+			namesHook[idx], (unsigned long long)durUs, budgetUs);
+}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+void Processing::watchdogMain()
+{
+	unique_lock<mutex> lock(mtxWatchdog);
+	HookSlot *pSlot;
+	uint64_t tNowNs;
+	uint32_t periodUs, budgetUs;
+
+	while (!exitWatchdog)
+	{
+		periodUs = budgetWatchdogUs / 2;
+		if (periodUs < 1000)
+			periodUs = 1000;
+
+		cvWatchdog.wait_for(lock, chrono::microseconds(periodUs));
+
+		budgetUs = budgetWatchdogUs;
+		if (!budgetUs)
+			continue;
+
+		tNowNs = tickNs();
+
+		pSlot = HookSlot::pSlotWdFirst;
+		for (; pSlot; pSlot = pSlot->pNext)
+			watchdogCheck(pSlot, tNowNs, uint64_t(budgetUs) * 1000);
+	}
+}
+
+/*
+ * Used with the watchdog locked. A call still running is
+ * reported once. The duration is logged again when it returns
+ */
+void Processing::watchdogCheck(HookSlot *pSlot, uint64_t tNowNs, uint64_t budgetNs)
+{
+	uint64_t tStartNs = pSlot->tStartNs.load(memory_order_acquire);
+	char bufId[CONFIG_PROC_ID_BUFFER_SIZE];
+	Processing *pProc;
+	uint8_t idx;
+
+	if (!tStartNs || tStartNs == pSlot->tReportedNs)
+		return;
+
+	if (tNowNs < tStartNs + budgetNs)
+		return;
+
+	// Process can't be destroyed while it is read
+	TreeReadGuard guard;
+
+	pProc = pSlot->pProc.load(memory_order_acquire);
+
+	// Function may have returned in the meantime
+	if (!pProc || pSlot->tStartNs.load(memory_order_relaxed) != tStartNs)
+		return;
+
+	pSlot->tReportedNs = tStartNs;
+
+	switch (pProc->mStateAbstract.load(memory_order_relaxed))
+	{
+	case PsInitializing:
+		idx = PpInit;
+		break;
+	case PsProcessing:
+		idx = PpProcess;
+		break;
+	default:
+		idx = PpShutdown;
+		break;
+	}
+
+	procId(bufId, bufId + sizeof(bufId), pProc);
+
+	wrnLog("%s is blocking its driver in %s() for %llu us",
+			bufId, namesHook[idx],
+			(unsigned long long)((tNowNs - tStartNs) / 1000));
+}
+
+void Processing::watchdogStop()
+{
+	thread *pThr;
+
+	{
+		Guard lock(mtxWatchdog);
+
+		exitWatchdog = true;
+		cvWatchdog.notify_one();
+
+		pThr = pThrWatchdog;
+		pThrWatchdog = NULL;
+	}
+
+	if (!pThr)
+		return;
+
+	pThr->join();
+	delete pThr;
+}
+#endif
+#endif
+
+void Processing::undrivenSet(Processing *pChild)
+{
+	dOrRel(pChild->mStatDrv, PsbDrvUndriven);
+
+	// Parents driving their children notice it themselves
+	if (pChild->mDriver != DrivenByParent && pChild->mpParent)
+		pChild->mpParent->wakeup();
+}
+
+void Processing::destroy(Processing *pChild)
+{
+	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
+	procId(childId, childId + sizeof(childId), pChild);
+
+	coreLog("child %s destroy()", childId);
+
+	if (pChild->mNumChildren)
+		errLog(-1, "destroying child with grand children");
+#if CONFIG_PROC_HAVE_REGISTRY
+	// Roots aren't removed by a parent
+	registryRemove(pChild);
+#endif
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	delete pChild->mpConfigDriver;
+	pChild->mpConfigDriver = NULL;
+
+	// Renderers left already
+	delete[] pChild->mpInfoSnap;
+	pChild->mpInfoSnap = NULL;
+
+	if (pChild->mpDriver)
+	{
+		coreLog("driver cleanup");
+		pFctDriverInternalCleanUp(pChild->mpDriver);
+		pChild->mpDriver = NULL;
+		coreLog("driver cleanup: done");
+	}
+#endif
+	DriverContext *pCtx = dLoadRlx(pChild->mpCtxDriver);
+
+	if (pChild->mppTmrPrev)
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		CtxGuard lock(pCtx);
+#endif
+		tmrRemove(pChild);
+	}
+#if CONFIG_PROC_HAVE_EPOLL
+	if (pCtx)
+	{
+		CtxGuard lock(pCtx);
+		fdRegsRelease(pCtx, pChild);
+	}
+#endif
+	if (pCtx && pCtx->pRoot == pChild)
+	{
+		ctxDriverDelete(pCtx);
+		dStoreRel(pChild->mpCtxDriver, (DriverContext *)NULL);
+	}
+
+	if (dLoadAcq(pChild->mStatParent) & PsbParStatic)
+	{
+		// Storage is owned by ProcStatic
+		pChild->~Processing();
+	}
+	else
+	{
+		coreLog("child %s delete()", childId);
+		delete pChild;
+		coreLog("child %s delete(): done", childId);
+	}
+
+	coreLog("child %s destroy(): done", childId);
+}
+
+void Processing::applicationClose()
+{
+	coreLog("closing application");
+
+#if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
+	coreLog("executing global destructors");
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+	list<FuncGlobDestruct>::iterator iter = globalDestructors.begin();
+
+	while (iter != globalDestructors.end())
+		(*iter++)();
+
+	globalDestructors.clear();
+#else
+	FuncGlobDestruct *pGlobDestrListElem = pGlobalDestructors;
+
+	while (pGlobDestrListElem && *pGlobDestrListElem)
+		(*pGlobDestrListElem++)();
+
+	if (pGlobalDestructors)
+		delete[] pGlobalDestructors;
+#endif
+	coreLog("executing global destructors: done");
+#else
+	coreLog("global destructors disabled");
+#endif
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	coreLog("stopping drivers");
+	driversStop();
+	coreLog("stopping drivers: done");
+#endif
+#if CONFIG_PROC_HAVE_REGISTRY
+	registryClear();
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG && CONFIG_PROC_HAVE_DRIVERS
+	watchdogStop();
+#endif
+	coreLog("closing application: done");
+}
+
+void Processing::globalDestructorRegister(FuncGlobDestruct globDestr)
+{
+#if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
+	coreLog("");
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+	globalDestructors.push_front(globDestr);
+	globalDestructors.unique();
+	coreLog(": done");
+#else
+	FuncGlobDestruct *pGlobDestrListElem = NULL;
+
+	if (!pGlobalDestructors)
+	{
+		size_t numDestrElements = CONFIG_PROC_NUM_MAX_GLOBAL_DESTRUCTORS + 1;
+
+		pGlobalDestructors = new dNoThrow FuncGlobDestruct[numDestrElements];
+		if (!pGlobalDestructors)
+		{
+			errLog(-1, "could not allocate global destructor list");
+			return;
+		}
+
+		pGlobDestrListElem = pGlobalDestructors;
+		for (size_t i = 0; i < numDestrElements; ++i)
+			*pGlobDestrListElem++ = NULL;
+	}
+
+	pGlobDestrListElem = pGlobalDestructors;
+	for (size_t i = 0; i < CONFIG_PROC_NUM_MAX_GLOBAL_DESTRUCTORS; ++i)
+	{
+		if (!*pGlobDestrListElem)
+		{
+			*pGlobDestrListElem = globDestr;
+			coreLog(": done");
+			return;
+		}
+
+		++pGlobDestrListElem;
+	}
+
+	errLog(-2, "could not register global destructor. no free slot available");
+#endif
+#else
+	(void)globDestr;
+	errLog(-1, "can't register global destructor. function disabled");
+#endif
+}
+
+// Processes must be freed by the allocator which allocated them
+static FlagProc allocatorUsed(false);
+
+void *Processing::operator new(size_t size) noexcept
+{
+	if (!dLoadRlx(allocatorUsed))
+		dStoreRel(allocatorUsed, true);
+
+	return pFctProcAlloc(size);
+}
+
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+void *Processing::operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	if (!dLoadRlx(allocatorUsed))
+		dStoreRel(allocatorUsed, true);
+
+	return pFctProcAlloc(size);
+}
+#endif
+
+void Processing::operator delete(void *p, size_t size)
+{
+	pFctProcFree(p, size);
+}
+
+// Must be set before the first process is created
+void Processing::allocatorSet(FuncProcAlloc pFctAlloc, FuncProcFree pFctFree)
+{
+	if (!pFctAlloc || !pFctFree)
+		return;
+
+	if (dLoadAcq(allocatorUsed))
+	{
+		wrnLog("allocator can't be changed after the first allocation");
+		return;
+	}
+
+	pFctProcAlloc = pFctAlloc;
+	pFctProcFree = pFctFree;
+}
+
+// Monotonic. Cheap inside of ticks
+uint64_t Processing::clockNs()
+{
+	if (clockVirtual)
+		return tClockVirtualNs;
+
+	if (tClockCachedNs > 1)
+		return tClockCachedNs;
+
+	uint64_t tNs = tickNs();
+
+	if (tClockCachedNs)
+		tClockCachedNs = tNs;
+
+	return tNs;
+}
+
+uint32_t Processing::clockMs()
+{
+	return (uint32_t)(clockNs() / 1000000);
+}
+
+/*
+ * Virtual clock for deterministic tests. Time only
+ * advances with clockAdvance(). Sleeping processes
+ * wake up once their expiry has been passed
+ */
+void Processing::clockVirtualSet(bool enabled, uint64_t tStartNs)
+{
+	tClockVirtualNs = tStartNs;
+	clockVirtual = enabled;
+}
+
+void Processing::clockAdvance(uint64_t durNs)
+{
+	tClockVirtualNs += durNs;
+}
+
+/*
+ * Milliseconds. Replaces std::chrono::steady_clock.
+ * Required on targets without it. Set before drivers are started
+ */
+void Processing::clockSourceSet(FuncClockSource pFctClock)
+{
+	pFctClockSource = pFctClock;
+}
+
+#if CONFIG_PROC_HAVE_TRACE
+/*
+ * Dump format. Native byte order
+ * - Header: "PTRC", uint32_t version
+ * - Records: uint64_t tNs, uint64_t idProc, uint32_t idDriver,
+ *            uint8_t type, uint8_t valOld, uint8_t valNew,
+ *            uint8_t lenStr, char str[lenStr]
+ * Events overwritten while dumping are skipped.
+ * Returns the number of records written
+ * Converter: tools/trace2chrome.py
+ */
+size_t Processing::traceDump(FuncTraceWrite pFctWrite, void *pUser)
+{
+	uint8_t rec[24 + 255];
+	const uint32_t version = 1;
+	DriverContext *pCtx;
+	TraceEvent ev;
+	uint32_t idxEnd, idx, idxCur;
+	uint64_t idProc;
+	size_t lenStr, numRecs = 0;
+
+	if (!pFctWrite)
+		return 0;
+
+	pFctWrite("PTRC", 4, pUser);
+	pFctWrite(&version, sizeof(version), pUser);
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxCtxTrace);
+#endif
+	for (pCtx = pCtxTraceFirst; pCtx; pCtx = pCtx->pTraceNext)
+	{
+		if (!pCtx->pEvents)
+			continue;
+#if CONFIG_PROC_HAVE_DRIVERS
+		idxEnd = pCtx->idxEventNext.load(memory_order_acquire);
+#else
+		idxEnd = pCtx->idxEventNext;
+#endif
+		idx = idxEnd > CONFIG_PROC_TRACE_NUM_EVENTS ?
+				idxEnd - CONFIG_PROC_TRACE_NUM_EVENTS : 0;
+
+		for (; idx != idxEnd; ++idx)
+		{
+			ev = pCtx->pEvents[idx & dTraceMask];
+#if CONFIG_PROC_HAVE_DRIVERS
+			atomic_thread_fence(memory_order_acquire);
+			idxCur = pCtx->idxEventNext.load(memory_order_relaxed);
+#else
+			idxCur = pCtx->idxEventNext;
+#endif
+			// Overwritten while copying
+			if (idxCur - idx >= CONFIG_PROC_TRACE_NUM_EVENTS)
+				continue;
+
+			idProc = (uintptr_t)ev.pProc;
+			lenStr = ev.pStr ? strlen(ev.pStr) : 0;
+			if (lenStr > 255)
+				lenStr = 255;
+
+			memcpy(rec, &ev.tNs, 8);
+			memcpy(rec + 8, &idProc, 8);
+			memcpy(rec + 16, &pCtx->idDriver, 4);
+			rec[20] = ev.type;
+			rec[21] = ev.valOld;
+			rec[22] = ev.valNew;
+			rec[23] = (uint8_t)lenStr;
+			if (lenStr)
+				memcpy(rec + 24, ev.pStr, lenStr);
+
+			pFctWrite(rec, 24 + lenStr, pUser);
+			++numRecs;
+		}
+	}
+
+	return numRecs;
+}
+#endif
+
+#if CONFIG_PROC_HAVE_REGISTRY
+// Used with the registry locked
+void Processing::registryGrow()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Registry *pReg = pRegistry.load(memory_order_relaxed);
+
+	// Readers may still use the previous bucket arrays
+	if (pRegistryRetired)
+	{
+		if (treeReadersBefore(epochRegistryRetired))
+			return;
+
+		registryDelete(pRegistryRetired);
+		pRegistryRetired = NULL;
+	}
+#else
+	Registry *pReg = pRegistry;
+#endif
+	Registry *pRegNew = registryCreate(2 * (pReg->mask + 1));
+	Processing *pProc, *pNext, *pFirst;
+	PtrProc *pLink;
+	uint32_t hash;
+
+	if (!pRegNew)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	seqRegistry.fetch_add(1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+#endif
+	// Every registered process is part of exactly one id chain
+	for (uint32_t k = 0; k <= pReg->mask; ++k)
+	{
+		pProc = pReg->pBuckets[RiId][k];
+		for (; pProc; pProc = pNext)
+		{
+			pNext = pProc->mpRegIdNext;
+
+			pLink = &pRegNew->pBuckets[RiId][pProc->mIdNum & pRegNew->mask];
+			pFirst = *pLink;
+			pProc->mpRegIdNext = pFirst;
+			*pLink = pProc;
+
+			hash = hashAdd(dFnvOffset, pProc->mName, strLen(pProc->mName));
+			chainInsert(&pRegNew->pBuckets[RiName][hash & pRegNew->mask], pProc,
+					&Processing::mpRegNameNext, &Processing::mppRegNamePrev);
+
+			chainInsert(&pRegNew->pBuckets[RiPath][pProc->mHashPath & pRegNew->mask], pProc,
+					&Processing::mpRegPathNext, &Processing::mppRegPathPrev);
+		}
+	}
+
+	pRegNew->numProcs = pReg->numProcs;
+#if CONFIG_PROC_HAVE_DRIVERS
+	pRegistry.store(pRegNew, memory_order_release);
+	seqRegistry.fetch_add(1, memory_order_release);
+
+	pRegistryRetired = pReg;
+	epochRegistryRetired = treeEpochAdvance();
+#else
+	pRegistry = pRegNew;
+	registryDelete(pReg);
+#endif
+}
+
+void Processing::registryAdd(Processing *pProc)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxRegistry);
+	Registry *pReg = pRegistry.load(memory_order_relaxed);
+#else
+	Registry *pReg = pRegistry;
+#endif
+	const Processing *pParent = pProc->mpParent;
+	Processing *pFirst;
+	PtrProc *pLink;
+	uint32_t hash;
+
+	if (!pReg)
+	{
+		pReg = registryCreate(CONFIG_PROC_REGISTRY_NUM_BUCKETS);
+		if (!pReg)
+		{
+			wrnLog("could not create process registry");
+			return;
+		}
+
+		pRegistry = pReg;
+	}
+
+	// Load factor of two at most
+	if (pReg->numProcs >= 2 * (pReg->mask + 1))
+	{
+		registryGrow();
+#if CONFIG_PROC_HAVE_DRIVERS
+		pReg = pRegistry.load(memory_order_relaxed);
+#else
+		pReg = pRegistry;
+#endif
+	}
+
+	pProc->mIdNum = idNumNext++;
+	if (!idNumNext)
+		idNumNext = 1;
+
+	// Path hash continues the one of the parent
+	if (pParent && pParent->mppRegNamePrev)
+		hash = hashAdd(pParent->mHashPath, "/", 1);
+	else
+		hash = dFnvOffset;
+
+	pProc->mHashPath = hashAdd(hash, pProc->mName, strLen(pProc->mName));
+
+	pLink = &pReg->pBuckets[RiId][pProc->mIdNum & pReg->mask];
+	pFirst = *pLink;
+	pProc->mpRegIdNext = pFirst;
+	*pLink = pProc;
+
+	hash = hashAdd(dFnvOffset, pProc->mName, strLen(pProc->mName));
+	chainInsert(&pReg->pBuckets[RiName][hash & pReg->mask], pProc,
+			&Processing::mpRegNameNext, &Processing::mppRegNamePrev);
+
+	chainInsert(&pReg->pBuckets[RiPath][pProc->mHashPath & pReg->mask], pProc,
+			&Processing::mpRegPathNext, &Processing::mppRegPathPrev);
+
+	++pReg->numProcs;
+}
+
+void Processing::registryRemove(Processing *pProc)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	Guard lock(mtxRegistry);
+	Registry *pReg = pRegistry.load(memory_order_relaxed);
+#else
+	Registry *pReg = pRegistry;
+#endif
+	Processing *pCur, *pFollow;
+	PtrProc *pLink;
+
+	if (!pReg || !pProc->mppRegNamePrev)
+		return;
+
+	pLink = &pReg->pBuckets[RiId][pProc->mIdNum & pReg->mask];
+	while ((pCur = *pLink) != pProc)
+		pLink = &pCur->mpRegIdNext;
+
+	pFollow = pProc->mpRegIdNext;
+	*pLink = pFollow;
+
+	chainRemove(pProc, &Processing::mpRegNameNext, &Processing::mppRegNamePrev);
+	chainRemove(pProc, &Processing::mpRegPathNext, &Processing::mppRegPathPrev);
+
+	--pReg->numProcs;
+}
+
+// Compares the path from its end to the root
+bool Processing::pathMatch(const Processing *pProc, const char *pPath, size_t len)
+{
+	size_t lenName;
+
+	while (1)
+	{
+		lenName = strLen(pProc->mName);
+
+		if (lenName > len ||
+				!strEqual(pPath + len - lenName, pProc->mName, lenName))
+			return false;
+
+		len -= lenName;
+		pProc = pProc->mpParent;
+
+		if (!pProc)
+			return !len;
+
+		if (!len || pPath[len - 1] != '/')
+			return false;
+
+		--len;
+	}
+}
+
+Processing *Processing::registryFind(uint8_t idx, uint32_t hash, const char *pKey)
+{
+	size_t len = strLen(pKey);
+	Processing *pProc;
+	Registry *pReg;
+#if CONFIG_PROC_HAVE_DRIVERS
+	uint32_t seq;
+
+	do
+	{
+		seq = seqRegistry.load(memory_order_acquire);
+		pReg = pRegistry.load(memory_order_acquire);
+#else
+		pReg = pRegistry;
+#endif
+		pProc = NULL;
+
+		if (pReg)
+			pProc = pReg->pBuckets[idx][hash & pReg->mask];
+
+		for (; pProc; )
+		{
+			if (idx == RiId)
+			{
+				if (pProc->mIdNum == hash)
+					break;
+
+				pProc = pProc->mpRegIdNext;
+				continue;
+			}
+
+			if (idx == RiName)
+			{
+				if (strLen(pProc->mName) == len &&
+						strEqual(pProc->mName, pKey, len))
+					break;
+
+				pProc = pProc->mpRegNameNext;
+				continue;
+			}
+
+			if (pProc->mHashPath == hash && pathMatch(pProc, pKey, len))
+				break;
+
+			pProc = pProc->mpRegPathNext;
+		}
+#if CONFIG_PROC_HAVE_DRIVERS
+		atomic_thread_fence(memory_order_acquire);
+	} while (seq & 1 || seqRegistry.load(memory_order_relaxed) != seq);
+#endif
+	return pProc;
+}
+
+/*
+ * Returned processes may be destroyed by their parents
+ * at any time. Use them on the driver of the tree or
+ * read them with procStr()
+ */
+Processing *Processing::procFind(uint32_t idNum)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	return registryFind(RiId, idNum, NULL);
+}
+
+Processing *Processing::procNameFind(const char *pName)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	if (!pName)
+		return NULL;
+
+	return registryFind(RiName,
+			hashAdd(dFnvOffset, pName, strLen(pName)), pName);
+}
+
+Processing *Processing::procPathFind(const char *pPath)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	if (!pPath)
+		return NULL;
+
+	return registryFind(RiPath,
+			hashAdd(dFnvOffset, pPath, strLen(pPath)), pPath);
+}
+
+/*
+ * Key is a numeric id, a path containing '/' or a name.
+ * The subtree of the process is written
+ */
+size_t Processing::procStr(char *pBuf, char *pBufEnd, const char *pKey, bool detailed)
+{
+	char *pBufStart = pBuf;
+	Processing *pProc = NULL;
+	const char *pCh = pKey;
+	uint32_t idNum = 0;
+	bool numeric = pKey && *pKey;
+	bool path = false;
+#if CONFIG_PROC_HAVE_DRIVERS
+	TreeReadGuard guard;
+#endif
+	for (; pCh && *pCh; ++pCh)
+	{
+		if (*pCh == '/')
+			path = true;
+
+		if (*pCh < '0' || *pCh > '9')
+			numeric = false;
+		else
+			idNum = 10 * idNum + uint32_t(*pCh - '0');
+	}
+
+	if (numeric)
+		pProc = procFind(idNum);
+	else if (path)
+		pProc = procPathFind(pKey);
+	else
+		pProc = procNameFind(pKey);
+
+	if (!pProc)
+	{
+		dInfo("Process not found");
+		return size_t(pBuf - pBufStart);
+	}
+
+	pBuf += pProc->processTreeStr(pBuf, pBufEnd, detailed);
+
+	return size_t(pBuf - pBufStart);
+}
+#endif
+
+size_t Processing::poolsStr(char *pBuf, char *pBufEnd)
+{
+	char *pBufStart = pBuf;
+#if CONFIG_PROC_HAVE_POOLS
+	ProcPool *pPool;
+	unsigned numUsed, numHits, numMisses, numSlabs;
+
+	for (size_t idx = 0; idx < dNumPools; ++idx)
+	{
+		pPool = &pools[idx];
+
+		numUsed = pPool->numUsed;
+		numHits = pPool->numHits;
+		numMisses = pPool->numMisses;
+		numSlabs = pPool->numSlabs;
+
+		if (!numHits && !numMisses)
+			continue;
+
+		dInfo("Pool %4u B\t\t\t%u used, %u hits, %u misses, %u slabs\n",
+				(unsigned)((idx + 1) * dPoolGranularity),
+				numUsed, numHits, numMisses, numSlabs);
+	}
+#else
+	(void)pBufEnd;
+#endif
+	return (size_t)(pBuf - pBufStart);
+}
+
+#if !CONFIG_PROC_HAVE_LIB_STD_C
+const char *Processing::strrchr(const char *x, char y)
+{
+	if (!x)
+		return NULL;
+
+	for (; *x; ++x)
+	{
+		if (*x == y)
+			return x;
+	}
+
+	return NULL;
+}
+
+void *Processing::memcpy(void *to, const void *from, size_t cnt)
+{
+	const char *pFrom = (const char *)from;
+	char *pTo = (char *)to;
+
+	for (; cnt; --cnt)
+		*pTo++ = *pFrom++;
+
+	return to;
+}
+#endif
+
+#if CONFIG_PROC_HAVE_DRIVERS
+// Default maximum parking of internal drivers. See driveLatencySet()
+void Processing::sleepUsInternalDriveSet(size_t delayUs)
+{
+#if defined(__linux__) || defined(__FreeBSD__) || defined(_WIN32)
+	if (!delayUs)
+		wrnLog("Sleep time for internal drivers set to zero => Busy loop");
+#endif
+	sleepInternalDriveUs = delayUs;
+}
+
+void Processing::sleepInternalDriveSet(chrono::microseconds delay)
+{
+	sleepUsInternalDriveSet((size_t)delay.count());
+}
+
+void Processing::sleepInternalDriveSet(chrono::milliseconds delay)
+{
+	sleepUsInternalDriveSet((size_t)delay.count() * 1000);
+}
+
+void Processing::sleepUsReactiveDriveSet(size_t delayUs)
+{
+	sleepReactiveDriveUs = delayUs;
+}
+
+// Idle ticks spinning and yielding before internal drivers park
+void Processing::numBurstInternalDriveSet(size_t numBurst)
+{
+	if (!numBurst)
+		return;
 
 	numBurstInternalDrive = numBurst;
 }
 
-void Processing::internalDriveSet(FuncInternalDrive pFctDrive)
+void Processing::internalDriveSet(FuncInternalDrive pFctDrive)
+{
+	if (!pFctDrive)
+		return;
+
+	pFctInternalDrive = pFctDrive;
+}
+
+void Processing::driverInternalCreateAndCleanUpSet(
+			FuncDriverInternalCreate pFctCreate,
+			FuncDriverInternalCleanUp pFctCleanUp)
+{
+	if (!pFctCreate || !pFctCleanUp)
+		return;
+
+	pFctDriverInternalCreate = pFctCreate;
+	pFctDriverInternalCleanUp = pFctCleanUp;
+}
+
+/*
+ * Deprecated. Creators with an opaque configuration
+ * receive ConfigDriver::pUser
+ */
+void Processing::driverInternalCreateAndCleanUpSet(
+			FuncDriverInternalCreateOpaque pFctCreate,
+			FuncDriverInternalCleanUp pFctCleanUp)
+{
+	if (!pFctCreate || !pFctCleanUp)
+		return;
+
+	pFctDriverInternalCreateOpaque = pFctCreate;
+	pFctDriverInternalCreate = driverInternalCreateOpaque;
+	pFctDriverInternalCleanUp = pFctCleanUp;
+}
+
+/*
+ * For drivers which don't park on the context of their
+ * process. Called by wakeup() with the root process of
+ * the context. Must be set before processes are started
+ */
+void Processing::driverInternalWakeupSet(FuncDriverInternalWakeup pFctWakeup)
+{
+	pFctDriverInternalWakeup = pFctWakeup;
+}
+
+/*
+ * pFctForkJoin executes pFctJob(pArg, idx) for all
+ * idx < numJobs and returns when all jobs are done.
+ * Without it parallel safe children are ticked serially
+ */
+void Processing::forkJoinSet(FuncForkJoin pFct)
+{
+	pFctForkJoin = pFct;
+}
+#endif
+
+#if CONFIG_PROC_HAVE_MIGRATION
+void Processing::migrationThresholdsSet(uint16_t hotUs, uint16_t coldUs)
+{
+	if (coldUs >= hotUs)
+		return;
+
+	migrationHotUs = hotUs;
+	migrationColdUs = coldUs;
+}
+#endif
+
+#if CONFIG_PROC_HAVE_WATCHDOG
+// Budget of each call of initialize(), process() and shutdown(). Zero disables
+void Processing::watchdogBudgetSet(uint32_t budgetUs)
+{
+	budgetWatchdogUs = budgetUs;
+}
+#endif
+
+// This area is used by the concrete processes
+
+Processing::Processing(const char *name)
+	: mState(0), mStateOld(0)
+	, mStateAbstract(PsExistent), mStatParent(0)
+	//, mStatDrv(0) <- Initialized below
+	, mStatSched(0)
+	, mWakeQueued(0), mWakeupReq(false)
+	, mSuccess(Pending)
+	, mDriver(DrivenByExternalDriver)
+	, mpCtxDriver(NULL)
+	, mpActiveFirst(NULL), mpActiveNext(NULL)
+	, mppTmrPrev(NULL), mpActivePrev(NULL)
+	, mpActiveLast(NULL)
+	, mpParent(NULL)
+	, mLevelTree(0), mLevelDriver(0)
+	, mNumChildren(0)
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+	, mNumChildrenMax(CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT)
+#endif
+	, mTmrExpiryMs(0)
+	, mNumChildrenPending(0), mNumChildrenFailed(0)
+	, mSuccessCounted(0)
+#if CONFIG_PROC_HAVE_MIGRATION
+	, mStatMigr(0), mDurTickUs(0)
+#endif
+	, mpChildFirst(NULL), mpChildLast(NULL)
+	, mpSiblingNext(NULL), mpSiblingPrev(NULL)
+	, mpWakeNext(NULL), mpTmrNext(NULL)
+	, mName(name)
+#if CONFIG_PROC_HAVE_DRIVERS
+	, mpDriver(NULL)
+	, mpConfigDriver(NULL)
+	, mpInfoSnap(NULL)
+#endif
+	, mpArg(NULL)
+#if CONFIG_PROC_HAVE_REGISTRY
+	, mIdNum(0), mHashPath(0)
+	, mpRegIdNext(NULL)
+	, mpRegNameNext(NULL), mppRegNamePrev(NULL)
+	, mpRegPathNext(NULL), mppRegPathPrev(NULL)
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+	, mProf()
+#endif
+{
+	procCoreLog("Processing()");
+
+	mStatDrv = 0;
+	if (disableTreeDefault)
+		mStatDrv = PsbDrvPrTreeDisable;
+}
+
+/*
+ * Protected destructor because of two reasons
+ * - Processes MUST be allocated on heap to be
+ *   able to maintain a process structure
+ * - Destruction of processes include stopping them
+ *   first. If a process has a new internal driver
+ *   it must be joined first. This can't be done
+ *   in a destructor because at this point the
+ *   processing function of the concrete process
+ *   doesn't exist anymore. Therefore an explicit
+ *   function repel() must be used by the concrete
+ *   processes to delete a child
+ */
+
+Processing::~Processing()
+{
+	procCoreLog("~Processing()");
+#if CONFIG_PROC_HAVE_DRIVERS
+	procCoreLog("mpDriver = 0x%08X", mpDriver);
+#endif
+}
+
+Processing *Processing::start(Processing *pChild, DriverMode driver)
+{
+	if (!pChild)
+	{
+		procCoreLog("could not start child. NULL pointer");
+		return NULL;
+	}
+
+	if (pChild == this)
+	{
+		procErrLog(-1, "could not start child. pointer to child is me");
+		return NULL;
+	}
+
+	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
+	procId(childId, childId + sizeof(childId), pChild);
+
+	procCoreLog("starting %s", childId);
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+	// Before the child is touched
+	if (!(dLoadAcq(pChild->mStatParent) & PsbParStarted) &&
+			mNumChildren >= mNumChildrenMax)
+	{
+		procErrLog(-2, "can't add child. maximum number of children reached");
+		return NULL;
+	}
+#endif
+	pChild->mLevelTree = mLevelTree + 1;
+	pChild->mDriver = driver;
+
+	DriverContext *pCtx = ctxDriverGet();
+	DriverContext *pCtxChild = dLoadRlx(pChild->mpCtxDriver);
+
+	// Driver context: Shared with parent or owned by child
+	bool ctxOwned = pCtxChild && pCtxChild->pRoot == pChild;
+
+	if (driver == DrivenByParent)
+	{
+		pChild->mpCtxDriver = pCtx;
+
+		if (ctxOwned)
+			ctxRetire(pCtx, pCtxChild);
+	}
+	else if (!ctxOwned)
+		pChild->mpCtxDriver = ctxDriverCreate(pChild);
+
+	// Add process to child list. Before a new driver
+	// is started which may already use the parent
+	if (!(dLoadAcq(pChild->mStatParent) & PsbParStarted))
+	{
+		procCoreLog("adding %s to child list", childId);
+		pChild->mpParent = this;
+#if CONFIG_PROC_HAVE_REGISTRY
+		// Roots are registered with their first child.
+		// Ids are set before tree walkers can see the child
+		if (!mpParent && !mIdNum)
+			registryAdd(this);
+
+		registryAdd(pChild);
+#endif
+		childAdd(pChild);
+		dOrRel(pChild->mStatParent, PsbParStarted);
+		pChild->successCount();
+		if (pChild->mStatSched & PsbSchedParallel)
+			dOrRlx(mStatSched, PsbSchedParallelChildren);
+		activeAdd(pChild);
+		procCoreLog("adding %s to child list: done", childId);
+#if CONFIG_PROC_HAVE_TRACE
+		traceAdd(TeStart, pChild, 0, driver, pChild->mName);
+#endif
+	}
+
+	// Optionally: Create and start new driver
+	if (driver == DrivenByNewInternalDriver)
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		if (!pChild->mpDriver)
+		{
+			procCoreLog("using new internal driver for %s", childId);
+			pChild->mLevelDriver = mLevelDriver + 1;
+
+			procCoreLog("creating new internal driver");
+			pChild->mpDriver = pFctDriverInternalCreate(pFctInternalDrive, pChild, pChild->mpConfigDriver);
+
+			delete pChild->mpConfigDriver;
+			pChild->mpConfigDriver = NULL;
+
+			if (!pChild->mpDriver)
+			{
+				procWrnLog("could not create internal driver. switching back to parental drive");
+
+				pChild->mDriver = DrivenByParent;
+				pChild->mLevelDriver = mLevelDriver;
+
+				pCtxChild = dLoadRlx(pChild->mpCtxDriver);
+				pChild->mpCtxDriver = pCtx;
+				ctxRetire(pCtx, pCtxChild);
+			} else
+				procCoreLog("creating new internal driver: done");
+		}
+#else
+		procWrnLog("system does not have internal drivers. switching back to parental drive");
+		pChild->mDriver = DrivenByParent;
+
+		pCtxChild = dLoadRlx(pChild->mpCtxDriver);
+		pChild->mpCtxDriver = pCtx;
+		ctxRetire(pCtx, pCtxChild);
+#endif
+	}
+	else if (driver == DrivenByExternalDriver)
+	{
+		procCoreLog("using external driver for %s", childId);
+		pChild->mLevelDriver = mLevelDriver + 1;
+	}
+	else if (driver == DrivenByParent)
+	{
+		procCoreLog("using parent as driver for %s", childId);
+		pChild->mLevelDriver = mLevelDriver;
+	}
+
+	procCoreLog("starting %s: done", childId);
+
+	return pChild;
+}
+
+Processing *Processing::cancel(Processing *pChild)
+{
+	if (!pChild)
+	{
+		procErrLog(-1, "could not cancel child. NULL pointer");
+		return NULL;
+	}
+
+	if (pChild == this)
+	{
+		procErrLog(-1, "could not cancel child. pointer to child is me");
+		return NULL;
+	}
+
+	if (!(dLoadAcq(pChild->mStatParent) & PsbParStarted))
+	{
+		procErrLog(-2, "tried to cancel orphan");
+		return NULL;
+	}
+
+	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
+	procId(childId, childId + sizeof(childId), pChild);
+
+	procCoreLog("canceling %s", childId);
+#if CONFIG_PROC_HAVE_TRACE
+	traceAdd(TeCancel, pChild, 0, 0, NULL);
+#endif
+	dOrRel(pChild->mStatParent, PsbParCanceled);
+	pChild->mWakeupReq = true;
+
+	if (pChild->mpCtxDriver != mpCtxDriver)
+		pChild->wakeup();
+	else
+		runnableSet(pChild);
+	procCoreLog("canceling %s: done", childId);
+
+	return pChild;
+}
+
+Processing *Processing::repel(Processing *pChild)
+{
+	procCoreLog("trying to repel child");
+
+	if (!cancel(pChild))
+		return NULL;
+
+	procCoreLog("setting child unused");
+#if CONFIG_PROC_HAVE_TRACE
+	traceAdd(TeRepel, pChild, 0, 0, NULL);
+#endif
+	pChild->unusedMark();
+	procCoreLog("setting child unused: done");
+
+	return NULL;
+}
+
+Processing *Processing::whenFinishedRepel(Processing *pChild)
+{
+	if (!pChild)
+	{
+		procErrLog(-1, "can't repel child when finished. NULL pointer");
+		return NULL;
+	}
+
+	if (pChild == this)
+	{
+		procErrLog(-1, "can't repel child when finished. pointer to child is me");
+		return NULL;
+	}
+
+	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
+	procId(childId, childId + sizeof(childId), pChild);
+
+	procCoreLog("repelling %s when finished", childId);
+	dOrRel(pChild->mStatParent, PsbParWhenFinishedUnused);
+	procCoreLog("repelling %s when finished: done", childId);
+
+	return NULL;
+}
+
+Success Processing::initialize()
+{
+	procCoreLog("initializing() not used");
+	return Positive;
+}
+
+Success Processing::shutdown()
+{
+	procCoreLog("shutdown() not used");
+	return Positive;
+}
+
+void Processing::processInfo(char *pBuf, char *pBufEnd)
+{
+	(void)pBuf;
+	(void)pBufEnd;
+}
+
+size_t Processing::processTrace(char *pBuf, char *pBufEnd)
+{
+	(void)pBuf;
+	(void)pBufEnd;
+	return 0;
+}
+
+// Return: Sorted by priority
+// - Negative .. At least one child is Negative. Error number of first err child
+// - Pending  .. At least one child is Pending
+// - Positive .. All children finished Positive
+Success Processing::childrenSuccess()
+{
+	// Pending first. See successCount()
+	uint16_t numPending = mNumChildrenPending;
+
+	if (!mNumChildrenFailed)
+		return numPending ? Pending : Positive;
+
+	// Rare. Search for the first failed child
+	const Processing *pChild = NULL;
+	Success sSuccess;
+
+	pChild = mpChildFirst;
+	for (; pChild; pChild = pChild->mpSiblingNext)
+	{
+		if (dLoadAcq(pChild->mStatParent) & PsbParUnused)
+			continue;
+
+		sSuccess = pChild->success();
+
+		if (sSuccess < Pending)
+			return sSuccess;
+	}
+
+	// Failed child is being marked as unused right now
+	return mNumChildrenPending ? Pending : Positive;
+}
+
+/*
+ * Registered file descriptors wake up the driver
+ * of this process when they become ready.
+ * Edge triggered. fdEventsReceived() tells the
+ * process if one of its descriptors got ready
+ */
+bool Processing::fdEventsAdd(int fd, bool writable)
+{
+#if CONFIG_PROC_HAVE_EPOLL
+	DriverContext *pCtx = mpCtxDriver;
+
+	if (!pCtx || fd < 0)
+		return false;
+
+	{
+		Guard lock(pCtx->mtxWait);
+
+		if (pCtx->fdEpoll < 0 && !ctxEpollCreate(pCtx))
+		{
+			procWrnLog("could not create epoll instance");
+			return false;
+		}
+	}
+
+	struct epoll_event ev;
+	int fdEpoll = pCtx->fdEpoll;
+	FdRegistration **ppReg, *pReg;
+	int res;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	if (writable)
+		ev.events |= EPOLLOUT;
+	ev.data.ptr = this;
+
+	CtxGuard lock(pCtx);
+
+	ppReg = fdRegFind(pCtx, fd);
+	pReg = *ppReg;
+
+	if (!pReg)
+	{
+		pReg = new dNoThrow FdRegistration;
+		if (!pReg)
+		{
+			procWrnLog("could not allocate registration of file descriptor %d", fd);
+			return false;
+		}
+
+		pReg->pNext = NULL;
+		pReg->fd = fd;
+		*ppReg = pReg;
+	}
+
+	// Descriptor numbers are reused. Last registration wins
+	pReg->pProc = this;
+	pReg->events = ev.events;
+#if CONFIG_PROC_HAVE_MIGRATION
+	// Registrations aren't moved by migrations
+	mStatMigr |= PsbMigrFd;
+#endif
+	res = epoll_ctl(fdEpoll, EPOLL_CTL_ADD, fd, &ev);
+	if (res < 0 && errno == EEXIST)
+		res = epoll_ctl(fdEpoll, EPOLL_CTL_MOD, fd, &ev);
+
+	if (res < 0)
+	{
+		*ppReg = pReg->pNext;
+		delete pReg;
+
+		procWrnLog("could not register file descriptor %d", fd);
+		return false;
+	}
+
+	return true;
+#else
+	(void)fd;
+	(void)writable;
+	return false;
+#endif
+}
+
+void Processing::fdEventsRemove(int fd)
+{
+#if CONFIG_PROC_HAVE_EPOLL
+	DriverContext *pCtx = mpCtxDriver;
+
+	if (!pCtx || fd < 0)
+		return;
+
+	int fdEpoll = pCtx->fdEpoll;
+	if (fdEpoll < 0)
+		return;
+
+	CtxGuard lock(pCtx);
+
+	FdRegistration **ppReg = fdRegFind(pCtx, fd);
+	FdRegistration *pReg = *ppReg;
+
+	// Descriptor number has been taken over by another process
+	if (pReg && pReg->pProc != this)
+		return;
+
+	if (pReg)
+	{
+		*ppReg = pReg->pNext;
+		delete pReg;
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+
+	(void)epoll_ctl(fdEpoll, EPOLL_CTL_DEL, fd, &ev);
+#if CONFIG_PROC_HAVE_MIGRATION
+	// Migratable again without registrations
+	for (pReg = pCtx->pFdRegFirst; pReg; pReg = pReg->pNext)
+	{
+		if (pReg->pProc == this)
+			return;
+	}
+
+	mStatMigr &= (uint8_t)~PsbMigrFd;
+#endif
+#else
+	(void)fd;
+#endif
+}
+
+bool Processing::fdEventsReceived()
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	uint8_t stat = mStatDrv.fetch_and((uint8_t)~PsbDrvFdEvent, memory_order_acquire);
+#else
+	uint8_t stat = mStatDrv;
+	mStatDrv &= (uint8_t)~PsbDrvFdEvent;
+#endif
+	return stat & PsbDrvFdEvent;
+}
+
+// The earliest timeout of all processes of the driver is used
+void Processing::timeoutWakeupSet(uint32_t delayMs)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	DriverContext *pCtx = mpCtxDriver;
+
+	if (!pCtx)
+		return;
+
+	chrono::steady_clock::time_point t;
+	t = chrono::steady_clock::now() + chrono::milliseconds(delayMs);
+
+	CtxGuard lock(pCtx);
+
+	if (pCtx->timeoutSet && pCtx->tTimeout <= t)
+		return;
+
+	pCtx->tTimeout = t;
+	pCtx->timeoutSet = true;
+#else
+	(void)delayMs;
+#endif
+}
+
+/*
+ * The process is not ticked for durationMs or until
+ * wakeup() is called, the process gets canceled or one
+ * of its registered file descriptors gets ready.
+ * Children are still ticked. Must be called from
+ * initialize(), process() or shutdown()
+ */
+void Processing::sleepSet(uint32_t durationMs)
+{
+	DriverContext *pCtx = mpCtxDriver;
+
+	if (!pCtx || !durationMs)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	CtxGuard lock(pCtx);
+#endif
+	if (mppTmrPrev)
+		tmrRemove(this);
+
+	if (!pCtx->wheel.numTimers)
+		pCtx->wheel.tMs = clockMs();
+
+	mTmrExpiryMs = pCtx->wheel.tMs + durationMs;
+	tmrInsert(pCtx, this);
+}
+
+/*
+ * Like sleepSet() but without timeout. The process
+ * is ticked again when wakeup() is called, the process
+ * gets canceled, one of its registered file descriptors
+ * gets ready or one of its children finishes
+ */
+void Processing::idleSet()
+{
+	dOrRlx(mStatDrv, PsbDrvIdle);
+}
+
+/*
+ * Tells the driver that work has been done although the
+ * state didn't change and Pending has been returned.
+ * Eg. data has been sent or received
+ */
+void Processing::workDoneSet()
+{
+	dOrRlx(mStatDrv, PsbDrvWorkDone);
+}
+
+#if CONFIG_PROC_HAVE_TRACE
+/*
+ * Lock free. Children ticked in parallel reserve their slots.
+ * Strings must have static storage duration
+ */
+void Processing::traceAdd(uint8_t type, const Processing *pProc,
+			uint8_t valOld, uint8_t valNew, const char *pStr)
+{
+	DriverContext *pCtx = mpCtxDriver;
+
+	if (!pCtx || !pCtx->pEvents)
+		return;
+
+#if CONFIG_PROC_HAVE_DRIVERS
+	uint32_t idx = pCtx->idxEventNext.fetch_add(1, memory_order_acq_rel);
+#else
+	uint32_t idx = pCtx->idxEventNext++;
+#endif
+	TraceEvent *pEvent = &pCtx->pEvents[idx & dTraceMask];
+
+	pEvent->tNs = tickNs();
+	pEvent->pProc = pProc;
+	pEvent->pStr = pStr;
+	pEvent->type = type;
+	pEvent->valOld = valOld;
+	pEvent->valNew = valNew;
+}
+#endif
+
+size_t Processing::mncpy(void *dest, size_t destSize, const void *src, size_t srcSize)
+{
+	if (destSize < srcSize)
+		return 0;
+
+	memcpy(dest, src, srcSize);
+
+	return srcSize;
+}
+
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+void Processing::maxChildrenSet(uint16_t cnt)
+{
+	mNumChildrenMax = cnt;
+}
+#endif
+
+DriverMode Processing::driver()	const { return mDriver;		}
+uint8_t Processing::levelDriver()	const { return mLevelDriver;	}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+/*
+ * Used when the process is started with DrivenByNewInternalDriver.
+ * The configuration is copied. The name must be
+ * valid until start() has been called
+ */
+void Processing::configDriverSet(const ConfigDriver &config)
+{
+	if (!mpConfigDriver)
+		mpConfigDriver = new dNoThrow ConfigDriver;
+
+	if (!mpConfigDriver)
+	{
+		procWrnLog("could not allocate driver configuration");
+		return;
+	}
+
+	*mpConfigDriver = config;
+}
+
+/*
+ * Deprecated. Sets ConfigDriver::pUser only.
+ * The configuration is not copied
+ */
+void Processing::configDriverSet(void *pConfigDriver)
+{
+	ConfigDriver config;
+
+	if (mpConfigDriver)
+		config = *mpConfigDriver;
+
+	config.pUser = pConfigDriver;
+	configDriverSet(config);
+}
+#endif
+
+size_t Processing::procId(char *pBuf, char *pBufEnd, const Processing *pProc)
+{
+	char *pBufStart = pBuf;
+
+	if (!pProc)
+		return 0;
+
+	if (showAddressInId)
+		dInfo("%p ", (const void *)pProc);
+
+	dInfo("%s", pProc->mName);
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+size_t Processing::progressStr(char *pBuf, char *pBufEnd, const int val, const int maxVal)
+{
+	char *pBufStart = pBuf;
+
+	int valCapped = val < maxVal ? val : maxVal;
+	valCapped = valCapped > 0 ? valCapped : 0;
+
+	int percent;
+	if (maxVal)
+		percent = (valCapped * 100) / maxVal;
+	else
+		percent = 0;
+
+	const int percentageStep = 5;
+	const int maxPercentageSteps = 100 / percentageStep;
+	int barCnt = percent / percentageStep;
+
+	dInfo("|");
+	for (int i = 0; i < barCnt; ++i)
+		dInfo("=");
+	dInfo("%*s", maxPercentageSteps - barCnt, "");
+	dInfo("|");
+
+	dInfo(" %3d%%", percent);
+
+	int maxValLen = 0;
+	int maxValCpy = maxVal;
+
+	for (; maxValCpy; ++maxValLen)
+		maxValCpy = (int)(((float)maxValCpy) * 0.1f);
+
+	dInfo(" %*d / %d", maxValLen, val, maxVal);
+
+	return (size_t)(pBuf - pBufStart);
+}
+
+// This area is used by the abstract process
+
+/*
+ * Used by the driver of the parent only.
+ * The child is fully set up before it gets
+ * visible to concurrent readers
+ */
+void Processing::childAdd(Processing *pChild)
+{
+	pChild->mpSiblingNext = NULL;
+	pChild->mpSiblingPrev = mpChildLast;
+
+	if (mpChildLast)
+		mpChildLast->mpSiblingNext = pChild;
+	else
+		mpChildFirst = pChild;
+
+	mpChildLast = pChild;
+	++mNumChildren;
+}
+
+/*
+ * Used by the driver of the parent only.
+ * The forward link of the child is kept. Concurrent
+ * readers standing on the child can continue
+ */
+void Processing::childRemove(Processing *pChild)
+{
+	Processing *pNext = pChild->mpSiblingNext;
+
+	if (pChild->mpSiblingPrev)
+		pChild->mpSiblingPrev->mpSiblingNext = pNext;
+	else
+		mpChildFirst = pNext;
+
+	if (pNext)
+		pNext->mpSiblingPrev = pChild->mpSiblingPrev;
+	else
+		mpChildLast = pChild->mpSiblingPrev;
+
+	pChild->mpSiblingPrev = NULL;
+	--mNumChildren;
+}
+
+// Used by the driver of the parent only
+void Processing::unusedMark()
+{
+	uint8_t flags = PsbParCanceled | PsbParUnused;
+	dOrRel(mStatParent, flags);
+	successCount();
+	mWakeupReq = true;
+
+	DriverContext *pCtx = dLoadRlx(mpCtxDriver);
+
+	if (pCtx && pCtx->pRoot == this)
+		wakeup();
+	else
+		runnableSet(this);
+}
+
+/*
+ * Keeps the counters of the parent in line with the
+ * success and usage of this child. Children driven by
+ * other drivers may race with their parent here.
+ * The counter a child is part of is swapped atomically
+ * and checked again until it's stable.
+ * The new counter is incremented before the old one is
+ * decremented. A parent reading the pending counter first
+ * never misses a child moving from pending to failed
+ */
+void Processing::successCount()
+{
+	Processing *pParent = mpParent;
+	uint8_t cntOld, cntNew;
+	Success success;
+
+	if (!pParent)
+		return;
+
+	while (1)
+	{
+		success = dLoadAcq(mSuccess);
+
+		if (dLoadAcq(mStatParent) & PsbParUnused)
+			cntNew = ScNone;
+		else if (success == Pending)
+			cntNew = ScPending;
+		else if (success == Positive)
+			cntNew = ScPositive;
+		else
+			cntNew = ScFailed;
+#if CONFIG_PROC_HAVE_DRIVERS
+		cntOld = mSuccessCounted.exchange(cntNew);
+#else
+		cntOld = mSuccessCounted;
+		mSuccessCounted = cntNew;
+#endif
+		if (cntOld == cntNew)
+			return;
+
+		if (cntNew == ScPending)
+			++pParent->mNumChildrenPending;
+		else if (cntNew == ScFailed)
+			++pParent->mNumChildrenFailed;
+
+		if (cntOld == ScPending)
+			--pParent->mNumChildrenPending;
+		else if (cntOld == ScFailed)
+			--pParent->mNumChildrenFailed;
+	}
+}
+
+// Storage is owned by ProcStatic
+void Processing::staticMark(Processing *pProc, uint16_t numChildrenMax)
+{
+	dOrRel(pProc->mStatParent, PsbParStatic);
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+	pProc->mNumChildrenMax = numChildrenMax;
+#else
+	(void)numChildrenMax;
+#endif
+}
+
+/*
+ * Ticks a child according to its weight. Repeated ticks
+ * stop as soon as the child leaves the runnable set
+ * Return: The next runnable sibling
+ */
+Processing *Processing::childWeightedTick(Processing *pChild, bool &worked)
+{
+	Processing *pNext;
+	uint8_t numTicks = pChild->weight();
+	bool undriven;
+
+	while (1)
+	{
+		undriven = dLoadAcq(pChild->mStatDrv) & PsbDrvUndriven;
+
+		if (parentalDrive(pChild))
+			worked = true;
+
+		pNext = pChild->mpActiveNext;
+
+		if (childTickFinish(pChild, undriven))
+		{
+			worked = true;
+			return pNext;
+		}
+#if CONFIG_PROC_HAVE_MIGRATION
+		if (pChild->mStatMigr & PsbMigrPending)
+		{
+			childMigrate(pChild);
+			worked = true;
+			return pNext;
+		}
+#endif
+		if (!--numTicks || !pChild->activeIs())
+			return pNext;
+	}
+}
+
+// Return: True if the child has been removed
+inline bool Processing::childTickFinish(Processing *pChild, bool undriven)
+{
+	bool undrivenNow = dLoadAcq(pChild->mStatDrv) & PsbDrvUndriven;
+	bool childCanBeRemoved;
+
+	// Child completion wakes up the parent
+	if (!undriven && undrivenNow &&
+			(mppTmrPrev || dLoadRlx(mStatDrv) & PsbDrvIdle))
+		mWakeupReq = true;
+
+	childCanBeRemoved = undrivenNow &&
+					dLoadAcq(pChild->mStatParent) & PsbParUnused;
+
+	// Other drivers may push the child concurrently.
+	// Closing the wake queue for it decides the race
+	if (childCanBeRemoved)
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		uint8_t queued = 0;
+
+		childCanBeRemoved = pChild->mWakeQueued.compare_exchange_strong(queued, 3);
+#else
+		childCanBeRemoved = !pChild->mWakeQueued;
+		if (childCanBeRemoved)
+			pChild->mWakeQueued = 3;
+#endif
+	}
+
+	if (!childCanBeRemoved)
+	{
+		if (childIdle(pChild))
+			activeRemove(pChild);
+
+		return false;
+	}
+
+	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
+	procId(childId, childId + sizeof(childId), pChild);
+
+	procCoreLog("removing %s from child list", childId);
+	childRemove(pChild);
+	activeRemove(pChild);
+#if CONFIG_PROC_HAVE_REGISTRY
+	registryRemove(pChild);
+#endif
+	procCoreLog("removing %s from child list: done", childId);
+#if CONFIG_PROC_HAVE_TRACE
+	traceAdd(TeDestroy, pChild, 0, 0, NULL);
+#endif
+	bool retired;
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		CtxGuard lock(mpCtxDriver);
+#endif
+		retired = childRetire(mpCtxDriver, pChild);
+	}
+
+	if (!retired)
+		destroy(pChild);
+
+	return true;
+}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+struct ForkTick
+{
+	Processing *pChild;
+	bool undriven;
+	bool worked;
+};
+
+/*
+ * Ticks all runnable parallel safe children in batches.
+ * Completion and removal are handled by the parent afterwards.
+ * Return: True if the children have been ticked
+ */
+bool Processing::childrenParallelTick(bool &worked)
+{
+	ForkTick ticks[CONFIG_PROC_NUM_FORK_MAX];
+	Processing *pChild;
+	DriverContext *pCtx = mpCtxDriver;
+	size_t numTicks = 0, i;
+
+	pChild = mpActiveFirst;
+	for (; pChild && numTicks < 2; pChild = pChild->mpActiveNext)
+	{
+		if (pChild->mStatSched & PsbSchedParallel)
+			++numTicks;
+	}
+
+	if (numTicks < 2 || !pCtx)
+		return false;
+
+	pChild = mpActiveFirst;
+	while (pChild)
+	{
+		numTicks = 0;
+
+		for (; pChild && numTicks < CONFIG_PROC_NUM_FORK_MAX; pChild = pChild->mpActiveNext)
+		{
+			if (!(pChild->mStatSched & PsbSchedParallel))
+				continue;
+
+			ticks[numTicks].pChild = pChild;
+			ticks[numTicks].undriven = dLoadAcq(pChild->mStatDrv) & PsbDrvUndriven;
+			ticks[numTicks].worked = false;
+			++numTicks;
+		}
+
+		if (numTicks > 1)
+		{
+			++pCtx->numForks;
+			pFctForkJoin(forkJobTick, ticks, numTicks);
+			--pCtx->numForks;
+		}
+		else if (numTicks)
+			forkJobTick(ticks, 0);
+
+		// Removed children are not followed anymore
+		for (i = 0; i < numTicks; ++i)
+		{
+			if (ticks[i].worked)
+				worked = true;
+
+			if (childTickFinish(ticks[i].pChild, ticks[i].undriven))
+				worked = true;
+		}
+	}
+
+	return true;
+}
+#endif
+
+void Processing::activeAdd(Processing *pChild)
+{
+	pChild->mpActiveNext = NULL;
+	pChild->mpActivePrev = mpActiveLast;
+
+	if (mpActiveLast)
+		mpActiveLast->mpActiveNext = pChild;
+	else
+		mpActiveFirst = pChild;
+
+	mpActiveLast = pChild;
+}
+
+void Processing::activeFirstAdd(Processing *pChild)
+{
+	pChild->mpActivePrev = NULL;
+	pChild->mpActiveNext = mpActiveFirst;
+
+	if (mpActiveFirst)
+		mpActiveFirst->mpActivePrev = pChild;
+	else
+		mpActiveLast = pChild;
+
+	mpActiveFirst = pChild;
+}
+
+void Processing::activeRemove(Processing *pChild)
+{
+	if (!pChild->activeIs())
+		return;
+
+	if (pChild->mpActivePrev)
+		pChild->mpActivePrev->mpActiveNext = pChild->mpActiveNext;
+	else
+		mpActiveFirst = pChild->mpActiveNext;
+
+	if (pChild->mpActiveNext)
+		pChild->mpActiveNext->mpActivePrev = pChild->mpActivePrev;
+	else
+		mpActiveLast = pChild->mpActivePrev;
+
+	pChild->mpActiveNext = NULL;
+	pChild->mpActivePrev = NULL;
+}
+
+bool Processing::activeIs() const
+{
+	return mpActivePrev || (mpParent && mpParent->mpActiveFirst == this);
+}
+
+// Return: True if work has been done in the tree of the child
+#if CONFIG_PROC_HAVE_DRIVERS
+void Processing::forkJobTick(void *pArg, size_t idx)
+{
+	ForkTick *pTick = (ForkTick *)pArg + idx;
+
+	pTick->worked = parentalDrive(pTick->pChild);
+}
+#endif
+
+inline bool Processing::parentalDrive(Processing *pChild)
+{
+	bool worked;
+
+	if (pChild->mDriver != DrivenByParent)
+		return false;
+
+	if (dLoadRlx(pChild->mStatDrv) & PsbDrvUndriven)
+		return false;
+#if CONFIG_PROC_HAVE_MIGRATION
+	if (pChild->mStatMigr & PsbMigrEnabled)
+		worked = measuredTick(pChild);
+	else
+#endif
+		worked = pChild->treeTick();
+
+	if (pChild->progress())
+		return worked;
+
+	undrivenSet(pChild);
+
+	return true;
+}
+
+#if CONFIG_PROC_HAVE_MIGRATION
+// Not inlined. Keeps the stack frames of deep trees small
+bool Processing::measuredTick(Processing *pChild)
+{
+	uint64_t tStartNs = tickNs();
+	bool worked;
+
+	worked = pChild->treeTick();
+	migrationMeasure(pChild, tickNs() - tStartNs, true);
+
+	return worked;
+}
+
+/*
+ * Called by the driver of the process after each tick.
+ * Average over the last ticks. Decisions are made after
+ * 16 ticks on the same driver
+ * Return: True if the process is marked for migration
+ */
+bool Processing::migrationMeasure(Processing *pProc, uint64_t durNs, bool parental)
+{
+	uint32_t durAvgUs = ((uint32_t)pProc->mDurTickUs * 7 + (uint32_t)(durNs / 1000)) / 8;
+	uint8_t stat = pProc->mStatMigr;
+
+	if (durAvgUs > 0xFFFF)
+		durAvgUs = 0xFFFF;
+
+	pProc->mDurTickUs = (uint16_t)durAvgUs;
+
+	if ((stat & PsbMigrCnt) != PsbMigrCnt)
+	{
+		pProc->mStatMigr = stat + dMigrCntOne;
+		return false;
+	}
+
+	if (stat & PsbMigrFd || pProc->mNumChildren ||
+			dLoadAcq(pProc->mStateAbstract) != PsProcessing ||
+			pProc->mStatSched & PsbSchedParallel)
+		return false;
+
+	if (parental && durAvgUs < migrationHotUs)
+		return false;
+
+	if (!parental && durAvgUs > migrationColdUs)
+		return false;
+
+	pProc->mStatMigr |= PsbMigrPending;
+
+	return true;
+}
+
+/*
+ * Used by the driver of the parent only. A child being
+ * demoted has left its own driver already
+ */
+void Processing::childMigrate(Processing *pChild)
+{
+	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
+	uint16_t durTickUs = pChild->mDurTickUs;
+	DriverContext *pCtx;
+
+	procId(childId, childId + sizeof(childId), pChild);
+	pChild->mStatMigr &= PsbMigrEnabled | PsbMigrFd;
+
+	if (pChild->mDriver == DrivenByParent)
+	{
+		pCtx = ctxDriverCreate(pChild);
+		if (!pCtx)
+			return;
+
+		ctxMove(pChild, pCtx);
+		pChild->mLevelDriver = mLevelDriver + 1;
+		pChild->mDriver = DrivenByNewInternalDriver;
+
+		pChild->mpDriver = pFctDriverInternalCreate(pFctInternalDrive, pChild, NULL);
+		if (pChild->mpDriver)
+		{
+			procInfLog("promoted %s to own driver. Tick %uus",
+						childId, durTickUs);
+			return;
+		}
+
+		procWrnLog("could not create internal driver for %s", childId);
+	}
+	else
+	{
+		procInfLog("demoting %s to parental drive. Tick %uus",
+					childId, durTickUs);
+
+		pFctDriverInternalCleanUp(pChild->mpDriver);
+		pCtx = dLoadRlx(pChild->mpCtxDriver);
+	}
+
+	pChild->mpDriver = NULL;
+	ctxMove(pChild, mpCtxDriver);
+	pChild->mLevelDriver = mLevelDriver;
+	pChild->mWakeupReq = true;
+	pChild->mDriver = DrivenByParent;
+
+	// wakeup() of other drivers may still use it
+	ctxRetire(mpCtxDriver, pCtx);
+}
+
+/*
+ * A pending timeout and registered file descriptors of
+ * the process are moved as well. They leave the old
+ * context before it can be retired
+ */
+void Processing::ctxMove(Processing *pProc, DriverContext *pCtx)
+{
+	DriverContext *pCtxOld = dLoadRlx(pProc->mpCtxDriver);
+	bool sleeping = pProc->mppTmrPrev;
+#if CONFIG_PROC_HAVE_EPOLL
+	fdRegsMove(pCtxOld, pCtx, pProc);
+#endif
+
+	if (sleeping)
+	{
+		CtxGuard lock(pCtxOld);
+		tmrRemove(pProc);
+	}
+
+	pProc->mpCtxDriver = pCtx;
+
+	if (!sleeping)
+		return;
+
+	CtxGuard lock(pCtx);
+
+	if (!pCtx->wheel.numTimers)
+		pCtx->wheel.tMs = clockMs();
+
+	tmrInsert(pCtx, pProc);
+}
+#endif
+
+/*
+ * A child driven by its parent is removed from the runnable
+ * set when it has nothing to do until an event occurs
+ * - Sleeping or idle and no wakeup requested
+ * - Finished but not yet unused
+ * and none of its own children are runnable
+ */
+bool Processing::childIdle(const Processing *pChild)
+{
+	if (pChild->mDriver != DrivenByParent)
+		return false;
+
+	if (pChild->mpActiveFirst)
+		return false;
+
+	// Same driver. No ordering needed
+	uint8_t statDrv = dLoadRlx(pChild->mStatDrv);
+
+	if (statDrv & PsbDrvUndriven)
+		return !(dLoadRlx(pChild->mStatParent) & PsbParUnused);
+
+	if (!pChild->mppTmrPrev && !(statDrv & PsbDrvIdle))
+		return false;
+
+	return !pChild->mWakeupReq;
+}
+
+/*
+ * Adds the process and all of its inactive ancestors
+ * to the runnable sets. Ancestors are always ticked
+ * before their children. Used by the driver only
+ */
+void Processing::runnableSet(Processing *pProc)
 {
-	if (!pFctDrive)
-		return;
+	Processing *pParent;
 
-	pFctInternalDrive = pFctDrive;
+	while (pProc->mDriver == DrivenByParent)
+	{
+		pParent = pProc->mpParent;
+		if (!pParent || pProc->activeIs())
+			break;
+
+		if (pProc->mStatSched & PsbSchedWeight)
+			pParent->activeFirstAdd(pProc);
+		else
+			pParent->activeAdd(pProc);
+		pProc = pParent;
+	}
 }
 
-void Processing::driverInternalCreateAndCleanUpSet(
-			FuncDriverInternalCreate pFctCreate,
-			FuncDriverInternalCleanUp pFctCleanUp)
+/*
+ * Other drivers can't touch the runnable sets.
+ * Therefore woken up processes are pushed to a
+ * lock free stack which is processed by the driver
+ * at the beginning of the next tick.
+ * mWakeQueued: 0 .. Not queued, 1 .. Pushing, 2 .. Queued, 3 .. Removed
+ *
+ * Literature
+ * - https://en.wikipedia.org/wiki/Treiber_stack
+ */
+void Processing::wakeQueueAdd(DriverContext *pCtx, Processing *pProc)
 {
-	if (!pFctCreate || !pFctCleanUp)
+#if CONFIG_PROC_HAVE_DRIVERS
+	uint8_t queued = 0;
+
+	if (!pProc->mWakeQueued.compare_exchange_strong(queued, 1))
 		return;
 
-	pFctDriverInternalCreate = pFctCreate;
-	pFctDriverInternalCleanUp = pFctCleanUp;
-}
-#endif
+	Processing *pFirst = pCtx->pWakeFirst.load(memory_order_relaxed);
 
-// This area is used by the concrete processes
+	do
+	{
+		pProc->mpWakeNext = pFirst;
+	} while (!pCtx->pWakeFirst.compare_exchange_weak(pFirst, pProc,
+					memory_order_release, memory_order_relaxed));
 
-Processing::Processing(const char *name)
-	: mState(0), mStateOld(0)
-	, mLevelTree(0), mLevelDriver(0)
-	, mName(name)
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-	, mChildList()
+	pProc->mWakeQueued.store(2, memory_order_release);
 #else
-	, mpChildList(NULL)
+	if (pProc->mWakeQueued)
+		return;
+
+	pProc->mpWakeNext = pCtx->pWakeFirst;
+	pCtx->pWakeFirst = pProc;
+	pProc->mWakeQueued = 2;
 #endif
+}
+
+void Processing::wakeQueueProcess(DriverContext *pCtx)
+{
+	Processing *pProc, *pNext;
 #if CONFIG_PROC_HAVE_DRIVERS
-	, mChildListMtx(), mpDriver(NULL)
-	, mpConfigDriver(NULL)
+	pProc = pCtx->pWakeFirst.exchange(NULL, memory_order_acquire);
+#else
+	pProc = pCtx->pWakeFirst;
+	pCtx->pWakeFirst = NULL;
 #endif
-	, mpArg(NULL), mSuccess(Pending), mNumChildren(0)
-	, mStateAbstract(PsExistent), mStatParent(0)
-	, mDriver(DrivenByExternalDriver)
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-	, mNumChildrenMax(CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT)
+	for (; pProc; pProc = pNext)
+	{
+		pNext = pProc->mpWakeNext;
+#if CONFIG_PROC_HAVE_DRIVERS
+		// Pusher is between linking and marking
+		while (pProc->mWakeQueued.load(memory_order_acquire) == 1)
+			this_thread::yield();
 #endif
-	//, mStatDrv(0) <- Initialized below
-{
-	procCoreLog("Processing()");
+		pProc->mpWakeNext = NULL;
+		pProc->mWakeQueued = 0;
 
-	mStatDrv = 0;
-	if (disableTreeDefault)
-		mStatDrv = PsbDrvPrTreeDisable;
+		runnableSet(pProc);
+	}
 }
 
-/*
- * Protected destructor because of two reasons
- * - Processes MUST be allocated on heap to be
- *   able to maintain a process structure
- * - Destruction of processes include stopping them
- *   first. If a process has a new internal driver
- *   it must be joined first. This can't be done
- *   in a destructor because at this point the
- *   processing function of the concrete process
- *   doesn't exist anymore. Therefore an explicit
- *   function repel() must be used by the concrete
- *   processes to delete a child
- */
-
-Processing::~Processing()
+// Roots of the tree create their context on first use
+DriverContext *Processing::ctxDriverGet()
 {
-	procCoreLog("~Processing()");
-#if CONFIG_PROC_HAVE_DRIVERS
-	procCoreLog("mpDriver = 0x%08X", mpDriver);
-#endif
+	DriverContext *pCtx = dLoadRlx(mpCtxDriver);
+
+	if (pCtx)
+		return pCtx;
+
+	pCtx = ctxDriverCreate(this);
+	dStoreRel(mpCtxDriver, pCtx);
+
+	return pCtx;
 }
 
-Processing *Processing::start(Processing *pChild, DriverMode driver)
+DriverContext *Processing::ctxDriverCreate(Processing *pRoot)
 {
-	if (!pChild)
+	DriverContext *pCtx = NULL;
+#if CONFIG_PROC_NUM_CTX_DRIVER_STATIC
+	for (size_t i = 0; i < CONFIG_PROC_NUM_CTX_DRIVER_STATIC; ++i)
 	{
-		procCoreLog("could not start child. NULL pointer");
-		return NULL;
+		if (ctxDriverStaticUsed[i])
+			continue;
+
+		ctxDriverStaticUsed[i] = true;
+		pCtx = &ctxDriverStatic[i];
+		break;
 	}
 
-	if (pChild == this)
+	if (!pCtx)
+#endif
+		pCtx = new dNoThrow DriverContext;
+	if (!pCtx)
 	{
-		procErrLog(-1, "could not start child. pointer to child is me");
+		errLog(-1, "could not allocate driver context");
 		return NULL;
 	}
 
-	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
-	procId(childId, childId + sizeof(childId), pChild);
+	pCtx->pRoot = pRoot;
+	pCtx->reactive = false;
+	memset(&pCtx->wheel, 0, sizeof(pCtx->wheel));
+	pCtx->pWakeFirst = NULL;
+#if CONFIG_PROC_HAVE_PROFILING
+	pCtx->durBusyNs = 0;
+	pCtx->durIdleNs = 0;
+	pCtx->tWaitEndNs = 0;
+	pCtx->profResetReq = false;
+#endif
+#if CONFIG_PROC_HAVE_DRIVERS
+	pCtx->pRetiredFirst = NULL;
+	pCtx->pCtxRetiredFirst = NULL;
+	pCtx->pCtxRetiredNext = NULL;
+	pCtx->epochRetired = 0;
+	pCtx->latencyMinUs = CONFIG_PROC_DRIVE_LATENCY_MIN_US;
+	pCtx->latencyMaxUs = 0;
+	pCtx->numTicksIdle = 0;
+	pCtx->numTicksBusy = 0;
+	pCtx->delayParkUs = 0;
+	pCtx->timeoutSet = false;
+	pCtx->wakeupPending = false;
+	pCtx->infoReq = false;
+	pCtx->numForks = 0;
+#endif
+#if CONFIG_PROC_HAVE_EPOLL
+	pCtx->fdEpoll = -1;
+	pCtx->fdWakeup = -1;
+	pCtx->pFdRegFirst = NULL;
+#endif
+#if CONFIG_PROC_HAVE_TRACE
+	pCtx->idxEventNext = 0;
+	pCtx->pTracePrev = NULL;
+	pCtx->pEvents = new dNoThrow TraceEvent[CONFIG_PROC_TRACE_NUM_EVENTS];
+	if (!pCtx->pEvents)
+		wrnLog("could not allocate trace events");
 
-	procCoreLog("starting %s", childId);
+	{
+#if CONFIG_PROC_HAVE_DRIVERS
+		Guard lock(mtxCtxTrace);
+#endif
+		pCtx->idDriver = idDriverNext++;
 
-	pChild->mLevelTree = mLevelTree + 1;
-	pChild->mDriver = driver;
+		pCtx->pTraceNext = pCtxTraceFirst;
+		if (pCtxTraceFirst)
+			pCtxTraceFirst->pTracePrev = pCtx;
+		pCtxTraceFirst = pCtx;
+	}
+#endif
+	return pCtx;
+}
 
-	// Optionally: Create and start new driver
-	if (driver == DrivenByNewInternalDriver)
+void Processing::ctxDriverDelete(DriverContext *pCtx)
+{
+	if (!pCtx)
+		return;
+#if CONFIG_PROC_HAVE_DRIVERS
+	retiredDestroy(pCtx, true);
+#endif
+#if CONFIG_PROC_HAVE_TRACE
 	{
 #if CONFIG_PROC_HAVE_DRIVERS
-		if (!pChild->mpDriver)
-		{
-			procCoreLog("using new internal driver for %s", childId);
-			pChild->mLevelDriver = mLevelDriver + 1;
+		Guard lock(mtxCtxTrace);
+#endif
+		if (pCtx->pTracePrev)
+			pCtx->pTracePrev->pTraceNext = pCtx->pTraceNext;
+		else
+			pCtxTraceFirst = pCtx->pTraceNext;
 
-			procCoreLog("creating new internal driver");
-			pChild->mpDriver = pFctDriverInternalCreate(pFctInternalDrive, pChild, pChild->mpConfigDriver);
-			pChild->mpConfigDriver = NULL;
+		if (pCtx->pTraceNext)
+			pCtx->pTraceNext->pTracePrev = pCtx->pTracePrev;
+	}
 
-			if (!pChild->mpDriver)
-			{
-				procWrnLog("could not create internal driver. switching back to parental drive");
+	delete[] pCtx->pEvents;
+#endif
+#if CONFIG_PROC_HAVE_EPOLL
+	FdRegistration *pReg;
 
-				pChild->mDriver = DrivenByParent;
-				pChild->mLevelDriver = mLevelDriver;
-			} else
-				procCoreLog("creating new internal driver: done");
-		}
+	while (pCtx->pFdRegFirst)
+	{
+		pReg = pCtx->pFdRegFirst;
+		pCtx->pFdRegFirst = pReg->pNext;
+		delete pReg;
+	}
+
+	if (pCtx->fdEpoll >= 0)
+	{
+		::close(pCtx->fdWakeup);
+		::close(pCtx->fdEpoll);
+	}
+#endif
+#if CONFIG_PROC_NUM_CTX_DRIVER_STATIC
+	if (pCtx >= ctxDriverStatic &&
+			pCtx < ctxDriverStatic + CONFIG_PROC_NUM_CTX_DRIVER_STATIC)
+	{
+		ctxDriverStaticUsed[pCtx - ctxDriverStatic] = false;
+		return;
+	}
+#endif
+	delete pCtx;
+}
+
+// Return: True if the child must not be destroyed yet
+bool Processing::childRetire(DriverContext *pCtx, Processing *pChild)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	if (!pCtx)
+		return false;
+
+	uint32_t epoch = treeEpochAdvance();
+
+	if (!treeReadersBefore(epoch))
+		return false;
+
+	// Removed from runnable set already
+	pChild->mpActiveNext = pCtx->pRetiredFirst;
+	pCtx->pRetiredFirst = pChild;
+	pCtx->epochRetired = epoch;
+
+	return true;
 #else
-		procWrnLog("system does not have internal drivers. switching back to parental drive");
-		pChild->mDriver = DrivenByParent;
+	(void)pCtx;
+	(void)pChild;
+	return false;
 #endif
+}
+
+/*
+ * Context replaced by a migration or a failed driver start.
+ * Other drivers may still be inside wakeup() with it.
+ * Used by the driver of pCtx after mpCtxDriver has been set
+ */
+void Processing::ctxRetire(DriverContext *pCtx, DriverContext *pCtxOld)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	uint32_t epoch = treeEpochAdvance();
+
+	if (pCtx && treeReadersBefore(epoch))
+	{
+		CtxGuard lock(pCtx);
+
+		pCtxOld->pCtxRetiredNext = pCtx->pCtxRetiredFirst;
+		pCtx->pCtxRetiredFirst = pCtxOld;
+		pCtx->epochRetired = epoch;
+
+		return;
 	}
-	else if (driver == DrivenByExternalDriver)
+
+	// Wakeups which got the old context before
+	if (pCtxOld->pWakeFirst)
+		wakeQueueProcess(pCtxOld);
+#else
+	(void)pCtx;
+#endif
+	ctxDriverDelete(pCtxOld);
+}
+
+#if CONFIG_PROC_HAVE_DRIVERS
+void Processing::retiredDestroy(DriverContext *pCtx, bool force)
+{
+	DriverContext *pCtxOld, *pCtxNext;
+	Processing *pChild, *pNext;
+
+	if (!force && treeReadersBefore(pCtx->epochRetired))
+		return;
+
+	pChild = pCtx->pRetiredFirst;
+	pCtx->pRetiredFirst = NULL;
+
+	for (; pChild; pChild = pNext)
 	{
-		procCoreLog("using external driver for %s", childId);
-		pChild->mLevelDriver = mLevelDriver + 1;
+		pNext = pChild->mpActiveNext;
+		pChild->mpActiveNext = NULL;
+
+		destroy(pChild);
 	}
-	else if (driver == DrivenByParent)
+
+	pCtxOld = pCtx->pCtxRetiredFirst;
+	pCtx->pCtxRetiredFirst = NULL;
+
+	for (; pCtxOld; pCtxOld = pCtxNext)
 	{
-		procCoreLog("using parent as driver for %s", childId);
-		pChild->mLevelDriver = mLevelDriver;
+		pCtxNext = pCtxOld->pCtxRetiredNext;
+
+		// Processes are kept until they left the wake queue
+		if (!force && pCtxOld->pWakeFirst)
+			wakeQueueProcess(pCtxOld);
+
+		ctxDriverDelete(pCtxOld);
 	}
+}
+#endif
+
+void Processing::ctxDriverWait(DriverContext *pCtx, size_t tmoUs)
+{
+#if CONFIG_PROC_HAVE_PROFILING
+	uint64_t tWaitStartNs = tickNs();
 
-	// Add process to child list
-	if (!(pChild->mStatParent & PsbParStarted))
+	if (pCtx && dLoadAcq(pCtx->profResetReq))
 	{
-		procCoreLog("adding %s to child list", childId);
-#if CONFIG_PROC_HAVE_DRIVERS
-		procCoreLog("Locking mChildListMtx");
-		Guard lock(mChildListMtx);
-		procCoreLog("Locking mChildListMtx: done");
+		dStoreRlx(pCtx->durBusyNs, 0);
+		dStoreRlx(pCtx->durIdleNs, 0);
+		dStoreRel(pCtx->profResetReq, false);
+	}
+
+	if (pCtx && pCtx->tWaitEndNs)
+		dStoreRlx(pCtx->durBusyNs, dLoadRlx(pCtx->durBusyNs) + tWaitStartNs - pCtx->tWaitEndNs);
 #endif
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-		mChildList.push_back(pChild);
-		++mNumChildren;
-#else
-		if (mNumChildren >= mNumChildrenMax)
+	ctxDriverPark(pCtx, tmoUs);
+#if CONFIG_PROC_HAVE_PROFILING
+	if (!pCtx)
+		return;
+
+	pCtx->tWaitEndNs = tickNs();
+	dStoreRlx(pCtx->durIdleNs, dLoadRlx(pCtx->durIdleNs) + pCtx->tWaitEndNs - tWaitStartNs);
+#endif
+}
+
+/*
+ * Literature
+ * - https://man7.org/linux/man-pages/man7/epoll.7.html
+ * - https://man7.org/linux/man-pages/man2/eventfd.2.html
+ */
+void Processing::ctxDriverPark(DriverContext *pCtx, size_t tmoUs)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	if (!pCtx)
+	{
+		this_thread::sleep_for(chrono::microseconds(tmoUs));
+		return;
+	}
+
+	if (pCtx->timeoutSet)
+	{
+		chrono::steady_clock::time_point tNow = chrono::steady_clock::now();
+
+		pCtx->timeoutSet = false;
+
+		if (pCtx->tTimeout <= tNow)
+			return;
+
+		size_t tmoLeftUs = (size_t)chrono::duration_cast<chrono::microseconds>(
+						pCtx->tTimeout - tNow).count();
+
+		if (tmoLeftUs < tmoUs)
+			tmoUs = tmoLeftUs;
+	}
+
+	if (pCtx->wheel.numTimers)
+	{
+		size_t tmoWheelUs = (size_t)tmrNextDelayMs(pCtx) * 1000;
+
+		if (tmoWheelUs < tmoUs)
+			tmoUs = tmoWheelUs;
+	}
+
+	if (!tmoUs)
+		return;
+#if CONFIG_PROC_HAVE_EPOLL
+	int fdEpoll = pCtx->fdEpoll.load(memory_order_acquire);
+
+	// Resolution of epoll_wait() is one millisecond
+	if (fdEpoll >= 0 && tmoUs >= 1000)
+	{
+		struct epoll_event events[16];
+		Processing *pProc;
+		int numEvents, i;
+
+		numEvents = epoll_wait(fdEpoll, events, 16, (int)(tmoUs / 1000));
+
+		for (i = 0; i < numEvents; ++i)
 		{
-			procErrLog(-2, "can't add child. maximum number of children reached");
-			return NULL;
+			pProc = (Processing *)events[i].data.ptr;
+
+			if (pProc)
+			{
+				dOrRel(pProc->mStatDrv, PsbDrvFdEvent);
+				pProc->mWakeupReq = true;
+				runnableSet(pProc);
+				continue;
+			}
+
+			uint64_t val;
+			ssize_t res = ::read(pCtx->fdWakeup, &val, sizeof(val));
+			(void)res;
 		}
 
-		childElemAdd(pChild);
-#endif
-		pChild->mStatParent |= PsbParStarted;
-		procCoreLog("adding %s to child list: done", childId);
+		pCtx->wakeupPending = false;
+		return;
+	}
+#endif
+	if (!pCtx->reactive)
+	{
+		this_thread::sleep_for(chrono::microseconds(tmoUs));
+		return;
+	}
+
+	unique_lock<mutex> lock(pCtx->mtxWait);
+
+	if (!pCtx->wakeupPending)
+		pCtx->cvWait.wait_for(lock, chrono::microseconds(tmoUs));
+
+	pCtx->wakeupPending = false;
+#else
+	(void)pCtx;
+	(void)tmoUs;
+#endif
+}
+
+/*
+ * Spin, yield, park. Return: Duration of parking
+ * - Work done: Tick again immediately. After numBurstInternalDrive
+ *   busy ticks in a row: Park for the minimum latency
+ * - numBurstInternalDrive idle ticks: Spin
+ * - Further numBurstInternalDrive idle ticks: Yield
+ * - Afterwards: Park with exponential backoff
+ *
+ * Literature
+ * - https://www.kernel.org/doc/html/latest/locking/mutex-design.html
+ * - https://en.wikipedia.org/wiki/Exponential_backoff
+ */
+size_t Processing::ctxDriverBackoff(DriverContext *pCtx, bool worked)
+{
+#if CONFIG_PROC_HAVE_DRIVERS
+	size_t maxUs = sleepInternalDriveUs;
+
+	if (!pCtx)
+		return worked ? 0 : maxUs;
+
+	if (worked)
+	{
+		pCtx->numTicksIdle = 0;
+		pCtx->delayParkUs = 0;
+
+		// State changes alone don't prove work.
+		// Busy streaks are therefore rate limited
+		if (++pCtx->numTicksBusy < numBurstInternalDrive)
+			return 0;
+
+		pCtx->numTicksBusy = 0;
+		return pCtx->latencyMinUs;
+	}
+
+	pCtx->numTicksBusy = 0;
+	++pCtx->numTicksIdle;
+
+	if (pCtx->numTicksIdle <= numBurstInternalDrive)
+		return 0;
+
+	if (pCtx->numTicksIdle <= 2 * numBurstInternalDrive)
+	{
+		this_thread::yield();
+		return 0;
 	}
 
-	procCoreLog("starting %s: done", childId);
+	if (pCtx->latencyMaxUs)
+		maxUs = pCtx->latencyMaxUs;
+	else if (pCtx->reactive)
+		maxUs = sleepReactiveDriveUs;
 
-	return pChild;
+	if (!pCtx->delayParkUs)
+		pCtx->delayParkUs = pCtx->latencyMinUs;
+	else
+		pCtx->delayParkUs <<= 1;
+
+	if (!pCtx->delayParkUs)
+		pCtx->delayParkUs = 1;
+
+	if (pCtx->delayParkUs > maxUs)
+		pCtx->delayParkUs = maxUs;
+
+	return pCtx->delayParkUs;
+#else
+	(void)pCtx;
+	(void)worked;
+	return 0;
+#endif
 }
 
-Processing *Processing::cancel(Processing *pChild)
+void Processing::tmrInsert(DriverContext *pCtx, Processing *pProc)
 {
-	if (!pChild)
-	{
-		procErrLog(-1, "could not cancel child. NULL pointer");
-		return NULL;
-	}
+	TimerWheel *pWheel = &pCtx->wheel;
+	uint32_t delay = pProc->mTmrExpiryMs - pWheel->tMs;
+	uint32_t expiry = pProc->mTmrExpiryMs;
+	Processing **ppSlot;
+	uint8_t lvl;
 
-	if (pChild == this)
+	// Expired or split delay. Expiry is checked again
+	if ((int32_t)delay < 0)
+		delay = 0;
+
+	if (delay >= dTmrDelayMax)
 	{
-		procErrLog(-1, "could not cancel child. pointer to child is me");
-		return NULL;
+		delay = dTmrDelayMax - 1;
+		expiry = pWheel->tMs + delay;
 	}
 
-	if (!(pChild->mStatParent & PsbParStarted))
+	for (lvl = 0; lvl < dNumTmrLevels - 1; ++lvl)
 	{
-		procErrLog(-2, "tried to cancel orphan");
-		return NULL;
+		if (delay < ((uint32_t)1 << (dTmrSlotBits * (lvl + 1))))
+			break;
 	}
 
-	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
-	procId(childId, childId + sizeof(childId), pChild);
+	ppSlot = &pWheel->slots[lvl][(expiry >> (dTmrSlotBits * lvl)) & dTmrSlotMask];
 
-	procCoreLog("canceling %s", childId);
-	pChild->mStatParent |= PsbParCanceled;
-	procCoreLog("canceling %s: done", childId);
+	pProc->mpTmrNext = *ppSlot;
+	if (*ppSlot)
+		(*ppSlot)->mppTmrPrev = &pProc->mpTmrNext;
+	pProc->mppTmrPrev = ppSlot;
+	*ppSlot = pProc;
 
-	return pChild;
+	++pWheel->numTimers;
 }
 
-Processing *Processing::repel(Processing *pChild)
+void Processing::tmrRemove(Processing *pProc)
 {
-	procCoreLog("trying to repel child");
+	DriverContext *pCtx = dLoadRlx(pProc->mpCtxDriver);
 
-	if (!cancel(pChild))
-		return NULL;
+	*pProc->mppTmrPrev = pProc->mpTmrNext;
+	if (pProc->mpTmrNext)
+		pProc->mpTmrNext->mppTmrPrev = pProc->mppTmrPrev;
 
-	procCoreLog("setting child unused");
-	pChild->unusedSet();
-	procCoreLog("setting child unused: done");
+	pProc->mpTmrNext = NULL;
+	pProc->mppTmrPrev = NULL;
 
-	return NULL;
+	if (pCtx)
+		--pCtx->wheel.numTimers;
 }
 
-Processing *Processing::whenFinishedRepel(Processing *pChild)
+/*
+ * Ticks from now to the next expiry or cascade.
+ * Level 0: Next occupied slot. Higher levels: Next slot
+ * boundary with an occupied slot. Ticks in between are skipped
+ */
+static uint32_t tmrEventNextMs(const TimerWheel *pWheel)
 {
-	if (!pChild)
+	uint32_t t = pWheel->tMs;
+	uint32_t dMin = 0xFFFFFFFF;
+	uint32_t tBound, shift, k;
+	uint8_t lvl;
+
+	for (k = 1; k <= dNumTmrSlots; ++k)
 	{
-		procErrLog(-1, "can't repel child when finished. NULL pointer");
-		return NULL;
+		if (!pWheel->slots[0][(t + k) & dTmrSlotMask])
+			continue;
+
+		dMin = k;
+		break;
 	}
 
-	if (pChild == this)
+	for (lvl = 1; lvl < dNumTmrLevels; ++lvl)
 	{
-		procErrLog(-1, "can't repel child when finished. pointer to child is me");
-		return NULL;
-	}
+		shift = dTmrSlotBits * lvl;
 
-	char childId[CONFIG_PROC_ID_BUFFER_SIZE];
-	procId(childId, childId + sizeof(childId), pChild);
+		for (k = 1; k <= dNumTmrSlots; ++k)
+		{
+			tBound = ((t >> shift) + k) << shift;
 
-	procCoreLog("repelling %s when finished", childId);
-	pChild->mStatParent |= PsbParWhenFinishedUnused;
-	procCoreLog("repelling %s when finished: done", childId);
+			if (tBound - t >= dMin)
+				break;
 
-	return NULL;
-}
+			if (!pWheel->slots[lvl][(tBound >> shift) & dTmrSlotMask])
+				continue;
 
-Success Processing::initialize()
-{
-	procCoreLog("initializing() not used");
-	return Positive;
-}
+			dMin = tBound - t;
+			break;
+		}
+	}
 
-Success Processing::shutdown()
-{
-	procCoreLog("shutdown() not used");
-	return Positive;
+	return dMin;
 }
 
-void Processing::processInfo(char *pBuf, char *pBufEnd)
+void Processing::tmrAdvance(DriverContext *pCtx, uint32_t tMs)
 {
-	(void)pBuf;
-	(void)pBufEnd;
-}
+	TimerWheel *pWheel = &pCtx->wheel;
+	Processing *pProc, *pNext;
+	uint32_t idx, dEventMs;
+	uint8_t lvl;
 
-size_t Processing::processTrace(char *pBuf, char *pBufEnd)
-{
-	(void)pBuf;
-	(void)pBufEnd;
-	return 0;
-}
+	if ((int32_t)(tMs - pWheel->tMs) <= 0)
+		return;
 
-// Return: Sorted by priority
-// - Negative .. At least one child is Negative. Error number of first err child
-// - Pending  .. At least one child is Pending
-// - Positive .. All children finished Positive
-Success Processing::childrenSuccess()
-{
-	if (!mNumChildren)
-		return Positive;
+	while (pWheel->numTimers && pWheel->tMs != tMs)
+	{
+		// Clock jumps cost one step per event only
+		dEventMs = tmrEventNextMs(pWheel);
+		if (dEventMs > tMs - pWheel->tMs)
+			break;
 
-	const Processing *pChild = NULL;
-	Success sSuccess;
-	bool oneIsPending = false;
+		pWheel->tMs += dEventMs;
 
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-	ChildIter iter = mChildList.begin();
-	while (iter != mChildList.end())
-	{
-		pChild = *iter++;
-#else
-	Processing **pChildListElem = mpChildList;
-	while (pChildListElem && *pChildListElem)
-	{
-		pChild = *pChildListElem++;
-#endif
-		if (pChild->mStatParent & PsbParUnused)
-			continue;
+		// Cascade: Move timers of higher levels down
+		for (lvl = 1; lvl < dNumTmrLevels; ++lvl)
+		{
+			if (pWheel->tMs & (((uint32_t)1 << (dTmrSlotBits * lvl)) - 1))
+				break;
+		}
 
-		sSuccess = pChild->success();
+		while (--lvl)
+		{
+			idx = (pWheel->tMs >> (dTmrSlotBits * lvl)) & dTmrSlotMask;
+			pProc = pWheel->slots[lvl][idx];
+			pWheel->slots[lvl][idx] = NULL;
 
-		if (sSuccess < Pending)
-			return sSuccess;
+			for (; pProc; pProc = pNext)
+			{
+				pNext = pProc->mpTmrNext;
+				--pWheel->numTimers;
+				tmrInsert(pCtx, pProc);
+			}
+		}
 
-		if (sSuccess == Pending)
-			oneIsPending = true;
-	}
+		idx = pWheel->tMs & dTmrSlotMask;
+		pProc = pWheel->slots[0][idx];
+		pWheel->slots[0][idx] = NULL;
 
-	if (oneIsPending)
-		return Pending;
+		for (; pProc; pProc = pNext)
+		{
+			pNext = pProc->mpTmrNext;
+			--pWheel->numTimers;
 
-	return Positive;
-}
+			// Split delay
+			if ((int32_t)(pProc->mTmrExpiryMs - pWheel->tMs) > 0)
+			{
+				tmrInsert(pCtx, pProc);
+				continue;
+			}
 
-size_t Processing::mncpy(void *dest, size_t destSize, const void *src, size_t srcSize)
-{
-	if (destSize < srcSize)
-		return 0;
+			pProc->mpTmrNext = NULL;
+			pProc->mppTmrPrev = NULL;
 
-	memcpy(dest, src, srcSize);
+			runnableSet(pProc);
+		}
+	}
 
-	return srcSize;
+	pWheel->tMs = tMs;
 }
 
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-void Processing::maxChildrenSet(uint16_t cnt)
+// Upper bound only. Timers of higher levels are due after the next wrap
+uint32_t Processing::tmrNextDelayMs(DriverContext *pCtx)
 {
-	if (mpChildList)
+	TimerWheel *pWheel = &pCtx->wheel;
+	uint32_t delay = 1;
+
+	for (; (pWheel->tMs + delay) & dTmrSlotMask; ++delay)
 	{
-		procErrLog(-1, "can't change max number of children. List created already");
-		return;
+		if (pWheel->slots[0][(pWheel->tMs + delay) & dTmrSlotMask])
+			break;
 	}
 
-	mNumChildrenMax = cnt;
+	return delay;
 }
-#endif
-
-DriverMode Processing::driver()	const { return mDriver;		}
-uint8_t Processing::levelDriver()	const { return mLevelDriver;	}
 
 #if CONFIG_PROC_HAVE_DRIVERS
-void Processing::configDriverSet(void *pConfigDriver)
-{
-	mpConfigDriver = pConfigDriver;
-}
-#endif
-
-size_t Processing::procId(char *pBuf, char *pBufEnd, const Processing *pProc)
+void Processing::internalDrive(void *pProc)
 {
-	char *pBufStart = pBuf;
+	Processing *pChild = (Processing *)pProc;
+	bool worked;
+	size_t delayUs;
 
-	if (!pProc)
-		return 0;
+	while (1)
+	{
+		if (!internalTick(pChild, worked))
+			break;
 
-	if (showAddressInId)
-		dInfo("%p ", (const void *)pProc);
+		DriverContext *pCtx = pChild->mpCtxDriver;
 
-	dInfo("%s", pProc->mName);
+		delayUs = ctxDriverBackoff(pCtx, worked);
+		if (!delayUs)
+			continue;
 
-	return (size_t)(pBuf - pBufStart);
+		ctxDriverWait(pCtx, delayUs);
+	}
 }
 
-size_t Processing::progressStr(char *pBuf, char *pBufEnd, const int val, const int maxVal)
+/*
+ * One tick of a process started with DrivenByNewInternalDriver.
+ * Used by internalDrive() and by drivers sharing threads.
+ * Return: False if the driver must leave the process.
+ * Either it has finished and is undriven or it has been
+ * handed back to its parent by a migration. It must not
+ * be touched anymore in both cases
+ */
+bool Processing::internalTick(Processing *pProc, bool &worked)
 {
-	char *pBufStart = pBuf;
+#if CONFIG_PROC_HAVE_MIGRATION
+	Processing *pParent = pProc->mpParent;
+	uint64_t tStartNs = 0;
 
-	int valCapped = val < maxVal ? val : maxVal;
-	valCapped = valCapped > 0 ? valCapped : 0;
-
-	int percent;
-	if (maxVal)
-		percent = (valCapped * 100) / maxVal;
-	else
-		percent = 0;
+	if (pProc->mStatMigr & PsbMigrEnabled)
+		tStartNs = tickNs();
+#endif
+	worked = pProc->treeTick();
 
-	const int percentageStep = 5;
-	const int maxPercentageSteps = 100 / percentageStep;
-	int barCnt = percent / percentageStep;
+	if (!pProc->progress())
+	{
+		undrivenSet(pProc);
+		return false;
+	}
+#if CONFIG_PROC_HAVE_MIGRATION
+	if (pProc->mStatMigr & PsbMigrEnabled && pParent &&
+			migrationMeasure(pProc, tickNs() - tStartNs, false))
+	{
+		pParent->wakeup();
+		return false;
+	}
+#endif
+	return true;
+}
 
-	dInfo("|");
-	for (int i = 0; i < barCnt; ++i)
-		dInfo("=");
-	dInfo("%*s", maxPercentageSteps - barCnt, "");
-	dInfo("|");
+void *Processing::driverInternalCreate(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig)
+{
+	DriverInternal *pDrv = NULL;
+	bool reusable = true;
+	bool reused;
+#if CONFIG_PROC_HAVE_PTHREAD
+	if (pConfig)
+		reusable = !pConfig->maskCpu &&
+					pConfig->policy == PolicyInherit &&
+					pConfig->idNodeNuma < 0 &&
+					!pConfig->sizeStack;
+#endif
+	driversExitJoin(false);
 
-	dInfo(" %3d%%", percent);
+	if (reusable)
+		pDrv = driverCachedPop();
 
-	int maxValLen = 0;
-	int maxValCpy = maxVal;
+	reused = pDrv;
 
-	for (; maxValCpy; ++maxValLen)
-		maxValCpy = (int)(((float)maxValCpy) * 0.1f);
+	if (!pDrv)
+	{
+		pDrv = new dNoThrow DriverInternal;
+		if (!pDrv)
+			return NULL;
 
-	dInfo(" %*d / %d", maxValLen, val, maxVal);
+		pDrv->exit = false;
+		pDrv->exited = false;
+		pDrv->pCachedNext = NULL;
+	}
 
-	return (size_t)(pBuf - pBufStart);
-}
+	pDrv->pFctDrive = pFctDrive;
+	pDrv->reusable = reusable;
+#if CONFIG_PROC_HAVE_PTHREAD
+	char *pBuf = pDrv->name;
+	char *pBufEnd = pBuf + sizeof(pDrv->name);
 
-// This area is used by the abstract process
+	pDrv->config = pConfig ? *pConfig : ConfigDriver();
 
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-Processing **Processing::childElemAdd(Processing *pChild)
-{
-	if (mNumChildren >= mNumChildrenMax)
-	{
-		procErrLog(-1, "can't add child. maximum number of children reached");
-		return NULL;
-	}
+	// Name of configuration is only valid until start()
+	if (pDrv->config.pName)
+		dInfo("%s", pDrv->config.pName);
+	else
+		dInfo("%p", pProc);
 
-	if (!mpChildList)
+	pDrv->config.pName = NULL;
+#else
+	if (pConfig)
+		wrnLog("configuration of drivers not supported");
+#endif
 	{
-		size_t numChildElements = mNumChildrenMax + 1;
+		Guard lock(pDrv->mtxPark);
 
-		mpChildList = new dNoThrow Processing *[numChildElements];
-		if (!mpChildList)
-		{
-			procErrLog(-2, "could not allocate child list");
-			return NULL;
-		}
+		pDrv->pProc = pProc;
+		pDrv->driving = true;
+		pDrv->released = false;
 
-		Processing **pChildListElem = mpChildList;
-		for (size_t i = 0; i < numChildElements; ++i)
-			*pChildListElem++ = NULL;
+		if (reused)
+			pDrv->cvPark.notify_one();
 	}
 
-	Processing **pEnd = &mpChildList[mNumChildren];
+	if (reused)
+		return pDrv;
+#if CONFIG_PROC_HAVE_PTHREAD
+	pthread_attr_t attr;
+	int res;
 
-	*pEnd = pChild;
-	++mNumChildren;
-
-	return pEnd;
-}
-
-Processing **Processing::childElemErase(Processing **pChildListElem)
-{
-	if (!mNumChildren)
+	res = pthread_attr_init(&attr);
+	if (res)
 	{
-		procErrLog(-1, "can't remove child. no children");
+		delete pDrv;
 		return NULL;
 	}
 
-	Processing **pMid = pChildListElem;
-	Processing **pLast = &mpChildList[mNumChildren - 1];
-
-	while (pChildListElem < pLast)
+	if (pDrv->config.sizeStack)
 	{
-		*pChildListElem = *(pChildListElem + 1);
-		++pChildListElem;
+		res = pthread_attr_setstacksize(&attr, pDrv->config.sizeStack);
+		if (res)
+			wrnLog("could not set stack size of driver: %s", strerror(res));
 	}
 
-	*pChildListElem = NULL;
-	--mNumChildren;
+	res = pthread_create(&pDrv->thread, &attr, driverInternalMain, pDrv);
+	pthread_attr_destroy(&attr);
 
-	return pMid;
-}
+	if (res)
+	{
+		delete pDrv;
+		return NULL;
+	}
+#else
+	pDrv->pThread = new dNoThrow thread(driverInternalLoop, pDrv);
+	if (!pDrv->pThread)
+	{
+		delete pDrv;
+		return NULL;
+	}
 #endif
+	return pDrv;
+}
 
-void Processing::parentalDrive(Processing *pChild)
+void *Processing::driverInternalCreateOpaque(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig)
 {
-	if (pChild->mDriver != DrivenByParent)
-		return;
-
-	if (pChild->mStatDrv & PsbDrvUndriven)
-		return;
-
-	pChild->treeTick();
-
-	if (pChild->progress())
-		return;
-
-	undrivenSet(pChild);
+	return pFctDriverInternalCreateOpaque(pFctDrive, pProc, pConfig ? pConfig->pUser : NULL);
 }
 
-#if CONFIG_PROC_HAVE_DRIVERS
-void Processing::internalDrive(void *pProc)
+/*
+ * The process has finished or has been handed back and
+ * is not touched by its driver anymore. The driver may
+ * still have to leave the drive function. Then it
+ * retires on its own. The caller never waits
+ */
+void Processing::driverInternalCleanUp(void *pDriver)
 {
-	Processing *pChild = (Processing *)pProc;
-	size_t i;
+	DriverInternal *pDrv = (DriverInternal *)pDriver;
+
+	driversExitJoin(false);
 
-	while (1)
 	{
-		for (i = 0; i < numBurstInternalDrive; ++i)
-			pChild->treeTick();
+		Guard lock(pDrv->mtxPark);
 
-		if (!pChild->progress())
+		if (pDrv->driving)
 		{
-			undrivenSet(pChild);
-			break;
-		}
+			pDrv->released = true;
 
-		if (!sleepInternalDriveUs)
-			continue;
+			Guard lockCached(mtxDrvCached);
+			++numDrvReleasing;
 
-		this_thread::sleep_for(chrono::microseconds(sleepInternalDriveUs));
+			return;
+		}
 	}
-}
-
-void *Processing::driverInternalCreate(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver)
-{
-	(void)pConfigDriver;
-	return new dNoThrow thread(pFctDrive, pProc);
-}
-
-void Processing::driverInternalCleanUp(void *pDriver)
-{
-	thread *pThread = (thread *)pDriver;
-
-	coreLog("thread join()");
-	if (pThread->joinable())
-		pThread->join();
-	coreLog("thread join(): done");
 
-	coreLog("thread delete()");
-	delete pThread;
-	pThread = NULL;
-	coreLog("thread delete(): done");
+	driverRetire(pDrv);
 }
 #endif
 
@@ -54,13 +54,48 @@
 #define dNoThrow
 #endif
 
-#if CONFIG_PROC_LOG_HAVE_CHRONO
+#if defined(__GNUC__)
+#define dNoInline __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define dNoInline __declspec(noinline)
+#else
+#define dNoInline
+#endif
+
+#if defined(__GNUC__)
+#define dDeprecated __attribute__((deprecated))
+#elif defined(_MSC_VER)
+#define dDeprecated __declspec(deprecated)
+#else
+#define dDeprecated
+#endif
+
+#if CONFIG_PROC_HAVE_CHRONO || CONFIG_PROC_LOG_HAVE_CHRONO
 #include <chrono>
 #endif
+class Processing;
+struct DriverContext;
+
 #if CONFIG_PROC_HAVE_DRIVERS
 #include <thread>
 #include <mutex>
+#include <atomic>
 typedef std::lock_guard<std::mutex> Guard;
+typedef std::atomic<bool> FlagProc;
+typedef std::atomic<uint8_t> StatProc;
+typedef std::atomic<Processing *> PtrProc;
+typedef std::atomic<DriverContext *> PtrCtx;
+typedef std::atomic<uint16_t> CntProc;
+typedef std::atomic<uint32_t> Cnt32Proc;
+typedef std::atomic<uint64_t> Cnt64Proc;
+#else
+typedef bool FlagProc;
+typedef uint8_t StatProc;
+typedef Processing *PtrProc;
+typedef DriverContext *PtrCtx;
+typedef uint16_t CntProc;
+typedef uint32_t Cnt32Proc;
+typedef uint64_t Cnt64Proc;
 #endif
 
 #ifdef _MSC_VER
@@ -79,6 +114,11 @@ enum DriverMode
 };
 
 typedef int16_t Success;
+#if CONFIG_PROC_HAVE_DRIVERS
+typedef std::atomic<Success> SuccessProc;
+#else
+typedef Success SuccessProc;
+#endif
 
 enum SuccessState
 {
@@ -86,10 +126,93 @@ enum SuccessState
 	Positive = 1
 };
 
+struct HookFrame;
+struct HookSlot;
+
+enum DriverPolicy
+{
+	PolicyInherit = 0,
+	PolicyOther,
+	PolicyFifo,
+	PolicyRoundRobin,
+};
+
+/*
+ * Configuration of a new internal driver.
+ * Set with configDriverSet() before the process is
+ * started with DrivenByNewInternalDriver.
+ * Default values keep the settings of the system
+ */
+struct ConfigDriver
+{
+	const char *pName;		// Name of thread. Max. 15 characters on Linux
+	uint64_t maskCpu;		// Affinity. Bit n: CPU n. 0: All CPUs
+	uint8_t policy;			// DriverPolicy
+	uint8_t priority;		// 1 .. 99 for PolicyFifo and PolicyRoundRobin
+	int16_t idNodeNuma;		// Preferred memory node. -1: Any
+	size_t sizeStack;		// Bytes. 0: Default of system
+	void *pUser;			// Opaque. Used by custom driver creators
+
+	ConfigDriver()
+		: pName(NULL)
+		, maskCpu(0)
+		, policy(PolicyInherit)
+		, priority(0)
+		, idNodeNuma(-1)
+		, sizeStack(0)
+		, pUser(NULL)
+	{}
+};
+
+enum TraceEventType
+{
+	TeStart = 1,
+	TeCancel,
+	TeRepel,
+	TeDestroy,
+	TeStateAbstract,
+	TeState,
+};
+
+#if CONFIG_PROC_HAVE_PROFILING
+/*
+ * Written by the driver of the process only. Other drivers
+ * read them relaxed and request resets with resetReq
+ */
+struct ProcProfile
+{
+	Cnt32Proc numTicks;
+	Cnt32Proc durMaxNs[3];
+	Cnt64Proc durSumNs[3];
+	FlagProc resetReq;
+};
+#endif
+
+#if CONFIG_PROC_HAVE_WATCHDOG
+// Buckets: Multiples of the budget 1, 2, 4, 8, 16, 32 and more
+#define dNumOverrunBuckets		6
+
+struct ProcOverrun
+{
+	uint32_t numOverruns;
+	uint32_t durMaxUs;
+	uint16_t numInBucket[dNumOverrunBuckets];
+};
+#endif
+
 typedef void (*FuncGlobDestruct)();
 typedef void (*FuncInternalDrive)(void *pProc);
-typedef void * /* pDriver */ (*FuncDriverInternalCreate)(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver);
+typedef void * /* pDriver */ (*FuncDriverInternalCreate)(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig);
+// Deprecated. Receives ConfigDriver::pUser
+typedef void * /* pDriver */ (*FuncDriverInternalCreateOpaque)(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver);
 typedef void (*FuncDriverInternalCleanUp)(void *pDriver);
+typedef void (*FuncDriverInternalWakeup)(void *pProc);
+typedef void (*FuncForkJob)(void *pArg, size_t idx);
+typedef void (*FuncForkJoin)(FuncForkJob pFctJob, void *pArg, size_t numJobs);
+typedef void (*FuncTraceWrite)(const void *pData, size_t len, void *pUser);
+typedef void *(*FuncProcAlloc)(size_t size);
+typedef void (*FuncProcFree)(void *p, size_t size);
+typedef uint32_t (*FuncClockSource)();
 
 class Processing
 {
@@ -97,25 +220,74 @@ class Processing
 public:
 	// This area is used by the client
 
-	void treeTick();
+	bool treeTick();
 	bool progress() const;
 	Success success() const;
 	void unusedSet();
 	void procTreeDisplaySet(bool display);
+	void parallelSet(bool parallel);
+	void weightSet(uint8_t weight);
+	uint8_t weight() const;
+	void teardownBulkSet(bool bulk);
+#if CONFIG_PROC_HAVE_MIGRATION
+	void migrationSet(bool migratable);
+#endif
 	void argSet(void *pArg);
+	void reactiveSet(bool reactive);
+	void driveLatencySet(uint32_t minUs, uint32_t maxUs);
+	void wakeup();
+	void eventsWait(uint32_t tmoMs);
 
 	bool initDone() const;
 	bool processDone() const;
 	bool shutdownDone() const;
 
 	size_t processTreeStr(char *pBuf, char *pBufEnd, bool detailed = true, bool colored = false);
+#if CONFIG_PROC_HAVE_REGISTRY
+	uint32_t procIdNum() const { return mIdNum; }
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+	void profileReset();
+	size_t profileStr(char *pBuf, char *pBufEnd) const;
+	size_t profileTopStr(char *pBuf, char *pBufEnd, size_t numTop);
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+	void overrunReset();
+	size_t overrunStr(char *pBuf, char *pBufEnd) const;
+	size_t overrunsStr(char *pBuf, char *pBufEnd);
+#endif
 #if CONFIG_PROC_HAVE_DRIVERS
-	void configDriverSet(void *pConfigDriver);
+	void configDriverSet(const ConfigDriver &config);
+	dDeprecated void configDriverSet(void *pConfigDriver);
 #endif
 	static void undrivenSet(Processing *pChild);
 	static void destroy(Processing *pChild);
 	static void applicationClose();
 	static void globalDestructorRegister(FuncGlobDestruct globDestr);
+	static void *operator new(size_t size) noexcept;
+#if CONFIG_PROC_HAVE_LIB_STD_CPP
+	static void *operator new(size_t size, const std::nothrow_t &) noexcept;
+#endif
+	static void operator delete(void *p, size_t size);
+	// Used by ProcStatic
+	static void *operator new(size_t size, void *pPlace) noexcept { (void)size; return pPlace; }
+	static void operator delete(void *p, void *pPlace) { (void)p; (void)pPlace; }
+	static void allocatorSet(FuncProcAlloc pFctAlloc, FuncProcFree pFctFree);
+	static size_t poolsStr(char *pBuf, char *pBufEnd);
+	static uint64_t clockNs();
+	static uint32_t clockMs();
+	static void clockVirtualSet(bool enabled, uint64_t tStartNs = 0);
+	static void clockAdvance(uint64_t durNs);
+	static void clockSourceSet(FuncClockSource pFctClock);
+#if CONFIG_PROC_HAVE_TRACE
+	static size_t traceDump(FuncTraceWrite pFctWrite, void *pUser);
+#endif
+#if CONFIG_PROC_HAVE_REGISTRY
+	static Processing *procFind(uint32_t idNum);
+	static Processing *procNameFind(const char *pName);
+	static Processing *procPathFind(const char *pPath);
+	static size_t procStr(char *pBuf, char *pBufEnd, const char *pKey, bool detailed = true);
+#endif
 #if !CONFIG_PROC_HAVE_LIB_STD_C
 	static const char *strrchr(const char *x, char y);
 	static void *memcpy(void *to, const void *from, size_t cnt);
@@ -126,11 +298,24 @@ public:
 	static void sleepUsInternalDriveSet(size_t delayUs);
 	static void sleepInternalDriveSet(std::chrono::microseconds delay);
 	static void sleepInternalDriveSet(std::chrono::milliseconds delay);
+	static void sleepUsReactiveDriveSet(size_t delayUs);
 	static void numBurstInternalDriveSet(size_t numBurst);
 	static void internalDriveSet(FuncInternalDrive pFctDrive);
+	static bool internalTick(Processing *pProc, bool &worked);
 	static void driverInternalCreateAndCleanUpSet(
 			FuncDriverInternalCreate pFctCreate,
 			FuncDriverInternalCleanUp pFctCleanUp);
+	dDeprecated static void driverInternalCreateAndCleanUpSet(
+			FuncDriverInternalCreateOpaque pFctCreate,
+			FuncDriverInternalCleanUp pFctCleanUp);
+	static void driverInternalWakeupSet(FuncDriverInternalWakeup pFctWakeup);
+	static void forkJoinSet(FuncForkJoin pFctForkJoin);
+#endif
+#if CONFIG_PROC_HAVE_MIGRATION
+	static void migrationThresholdsSet(uint16_t hotUs, uint16_t coldUs);
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+	static void watchdogBudgetSet(uint32_t budgetUs);
 #endif
 
 protected:
@@ -150,10 +335,23 @@ protected:
 	virtual Success process() = 0;
 	virtual Success shutdown();
 
+	// Called by the driver of the process only. Renderers on
+	// other drivers get the output of the latest request
 	virtual void processInfo(char *pBuf, char *pBufEnd);
 	virtual size_t processTrace(char *pBuf, char *pBufEnd);
 
 	Success childrenSuccess();
+	bool fdEventsAdd(int fd, bool write = false);
+	void fdEventsRemove(int fd);
+	bool fdEventsReceived();
+	void timeoutWakeupSet(uint32_t delayMs);
+	void sleepSet(uint32_t durationMs);
+	void idleSet();
+	void workDoneSet();
+#if CONFIG_PROC_HAVE_TRACE
+	void traceAdd(uint8_t type, const Processing *pProc,
+			uint8_t valOld, uint8_t valNew, const char *pStr);
+#endif
 	size_t mncpy(void *dest, size_t destSize, const void *src, size_t srcSize);
 #if !CONFIG_PROC_HAVE_LIB_STD_CPP
 	void maxChildrenSet(uint16_t cnt);
@@ -170,74 +368,161 @@ protected:
 private:
 	// This area is used by the abstract process
 
+	template<typename T, uint16_t numChildrenMax> friend class ProcStatic;
+
 	Processing()
 		: mState(0), mStateOld(0)
+		, mStateAbstract(0), mStatParent(0)
+		, mStatDrv(0), mStatSched(0)
+		, mWakeQueued(0), mWakeupReq(false)
+		, mSuccess(Pending)
+		, mDriver(DrivenByExternalDriver)
+		, mpCtxDriver(NULL)
+		, mpActiveFirst(NULL), mpActiveNext(NULL)
+		, mppTmrPrev(NULL), mpActivePrev(NULL)
+		, mpActiveLast(NULL)
+		, mpParent(NULL)
 		, mLevelTree(0), mLevelDriver(0)
-		, mName(NULL)
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-		, mChildList()
-#else
-		, mpChildList(NULL)
+		, mNumChildren(0)
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+		, mNumChildrenMax(CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT)
 #endif
+		, mTmrExpiryMs(0)
+		, mNumChildrenPending(0), mNumChildrenFailed(0)
+		, mSuccessCounted(0)
+#if CONFIG_PROC_HAVE_MIGRATION
+		, mStatMigr(0), mDurTickUs(0)
+#endif
+		, mpChildFirst(NULL), mpChildLast(NULL)
+		, mpSiblingNext(NULL), mpSiblingPrev(NULL)
+		, mpWakeNext(NULL), mpTmrNext(NULL)
+		, mName(NULL)
 #if CONFIG_PROC_HAVE_DRIVERS
-		, mChildListMtx(), mpDriver(NULL)
+		, mpDriver(NULL)
 		, mpConfigDriver(NULL)
+		, mpInfoSnap(NULL)
 #endif
-		, mpArg(NULL), mSuccess(Pending), mNumChildren(0)
-		, mStateAbstract(0), mStatParent(0)
-		, mDriver(DrivenByExternalDriver)
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-		, mNumChildrenMax(CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT)
+		, mpArg(NULL)
+#if CONFIG_PROC_HAVE_REGISTRY
+		, mIdNum(0), mHashPath(0)
+		, mpRegIdNext(NULL)
+		, mpRegNameNext(NULL), mppRegNamePrev(NULL)
+		, mpRegPathNext(NULL), mppRegPathPrev(NULL)
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+		, mProf()
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+		, mOvr()
 #endif
-		, mStatDrv(0)
 	{}
 	Processing(const Processing &)
 		: mState(0), mStateOld(0)
+		, mStateAbstract(0), mStatParent(0)
+		, mStatDrv(0), mStatSched(0)
+		, mWakeQueued(0), mWakeupReq(false)
+		, mSuccess(Pending)
+		, mDriver(DrivenByExternalDriver)
+		, mpCtxDriver(NULL)
+		, mpActiveFirst(NULL), mpActiveNext(NULL)
+		, mppTmrPrev(NULL), mpActivePrev(NULL)
+		, mpActiveLast(NULL)
+		, mpParent(NULL)
 		, mLevelTree(0), mLevelDriver(0)
-		, mName(NULL)
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-		, mChildList()
-#else
-		, mpChildList(NULL)
+		, mNumChildren(0)
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+		, mNumChildrenMax(CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT)
+#endif
+		, mTmrExpiryMs(0)
+		, mNumChildrenPending(0), mNumChildrenFailed(0)
+		, mSuccessCounted(0)
+#if CONFIG_PROC_HAVE_MIGRATION
+		, mStatMigr(0), mDurTickUs(0)
 #endif
+		, mpChildFirst(NULL), mpChildLast(NULL)
+		, mpSiblingNext(NULL), mpSiblingPrev(NULL)
+		, mpWakeNext(NULL), mpTmrNext(NULL)
+		, mName(NULL)
 #if CONFIG_PROC_HAVE_DRIVERS
-		, mChildListMtx(), mpDriver(NULL)
+		, mpDriver(NULL)
 		, mpConfigDriver(NULL)
+		, mpInfoSnap(NULL)
 #endif
-		, mpArg(NULL), mSuccess(Pending), mNumChildren(0)
-		, mStateAbstract(0), mStatParent(0)
-		, mDriver(DrivenByExternalDriver)
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-		, mNumChildrenMax(CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT)
+		, mpArg(NULL)
+#if CONFIG_PROC_HAVE_REGISTRY
+		, mIdNum(0), mHashPath(0)
+		, mpRegIdNext(NULL)
+		, mpRegNameNext(NULL), mppRegNamePrev(NULL)
+		, mpRegPathNext(NULL), mppRegPathPrev(NULL)
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+		, mProf()
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+		, mOvr()
 #endif
-		, mStatDrv(0)
 	{}
 	Processing &operator=(const Processing &)
 	{
 		mState = 0;
 		mStateOld = 0;
+		mStateAbstract = 0;
+		mStatParent = 0;
+		mStatDrv = 0;
+		mStatSched = 0;
+		mWakeQueued = 0;
+		mWakeupReq = false;
+		mSuccess = Pending;
+		mDriver = DrivenByExternalDriver;
+		mpCtxDriver = NULL;
+		mpActiveFirst = NULL;
+		mpActiveNext = NULL;
+		mppTmrPrev = NULL;
+		mpActivePrev = NULL;
+		mpActiveLast = NULL;
+		mpParent = NULL;
 		mLevelTree = 0;
 		mLevelDriver = 0;
-		mName = NULL;
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-		mChildList.clear();
-#else
-		mpChildList = NULL;
+		mNumChildren = 0;
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+		mNumChildrenMax = CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT;
 #endif
+		mTmrExpiryMs = 0;
+		mNumChildrenPending = 0;
+		mNumChildrenFailed = 0;
+		mSuccessCounted = 0;
+#if CONFIG_PROC_HAVE_MIGRATION
+		mStatMigr = 0;
+		mDurTickUs = 0;
+#endif
+		mpChildFirst = NULL;
+		mpChildLast = NULL;
+		mpSiblingNext = NULL;
+		mpSiblingPrev = NULL;
+		mpWakeNext = NULL;
+		mpTmrNext = NULL;
+		mName = NULL;
 #if CONFIG_PROC_HAVE_DRIVERS
 		mpDriver = NULL;
 		mpConfigDriver = NULL;
+		mpInfoSnap = NULL;
 #endif
 		mpArg = NULL;
-		mSuccess = Pending;
-		mNumChildren = 0;
-		mStateAbstract = 0;
-		mStatParent = 0;
-		mDriver = DrivenByExternalDriver;
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-		mNumChildrenMax = CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT;
+#if CONFIG_PROC_HAVE_REGISTRY
+		mIdNum = 0;
+		mHashPath = 0;
+		mpRegIdNext = NULL;
+		mpRegNameNext = NULL;
+		mppRegNamePrev = NULL;
+		mpRegPathNext = NULL;
+		mppRegPathPrev = NULL;
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+		profileClear();
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+		memset(&mOvr, 0, sizeof(mOvr));
 #endif
-		mStatDrv = 0;
 
 		return *this;
 	}
@@ -245,50 +530,187 @@ private:
 	/* member functions */
 
 	/* member variables */
+
+	// Hot. Touched by every tick of the parent. Together with
+	// the vtable pointer and mState they fit into one cache line
+	// Lifecycle fields. Polled by parents on other drivers
+	// - mStateAbstract: Own driver. Release/acquire
+	// - mStatParent: Parent. Release/acquire
+	// - mStatDrv: Own driver and poller. Done and undriven bits
+	//   and fd events release/acquire. Remaining bits relaxed
+	// - mSuccess: Own driver. Released before ProcessDone
+	// - mpCtxDriver: Parent. Read by wakeup() of other drivers.
+	//   Replaced contexts are retired
+	StatProc mStateAbstract;
+	StatProc mStatParent;
+	StatProc mStatDrv;
+	StatProc mStatSched;
+	StatProc mWakeQueued;
+	FlagProc mWakeupReq;
+	SuccessProc mSuccess;
+	DriverMode mDriver;
+	PtrCtx mpCtxDriver;
+	Processing *mpActiveFirst;
+	Processing *mpActiveNext;
+	Processing **mppTmrPrev;
+	Processing *mpActivePrev;
+
+	// Cold
+	Processing *mpActiveLast;
+	Processing *mpParent;
 	uint8_t mLevelTree;
 	uint8_t mLevelDriver;
+	uint16_t mNumChildren;
+#if !CONFIG_PROC_HAVE_LIB_STD_CPP
+	uint16_t mNumChildrenMax;
+#endif
+	uint32_t mTmrExpiryMs;
 
-	const char *mName;
-
-#if CONFIG_PROC_HAVE_LIB_STD_CPP
-	std::list<Processing *> mChildList;
-#else
-	Processing **childElemAdd(Processing *pChild);
-	Processing **childElemErase(Processing **pChildListElem);
-	Processing **mpChildList;
+	// Children not yet unused, counted by their success.
+	// Each child records the counter it is part of
+	CntProc mNumChildrenPending;
+	CntProc mNumChildrenFailed;
+	StatProc mSuccessCounted;
+#if CONFIG_PROC_HAVE_MIGRATION
+	StatProc mStatMigr;
+	uint16_t mDurTickUs;
 #endif
+
+	// Intrusive child list. No allocations
+	// Readers don't lock. Forward links are published atomically
+	PtrProc mpChildFirst;
+	Processing *mpChildLast;
+	PtrProc mpSiblingNext;
+	Processing *mpSiblingPrev;
+
+	Processing *mpWakeNext;
+	Processing *mpTmrNext;
+	const char *mName;
 #if CONFIG_PROC_HAVE_DRIVERS
-	std::mutex mChildListMtx;
 	void *mpDriver;
-	void *mpConfigDriver;
+	ConfigDriver *mpConfigDriver;
+	// Output of processInfo() for renderers on other drivers
+	char *mpInfoSnap;
 #endif
 	void *mpArg;
-	Success mSuccess;
-	uint16_t mNumChildren;
-	uint8_t mStateAbstract;
-	uint8_t mStatParent;
-	DriverMode mDriver;
-#if !CONFIG_PROC_HAVE_LIB_STD_CPP
-	uint16_t mNumChildrenMax;
+#if CONFIG_PROC_HAVE_REGISTRY
+	// Hash chains of the registry. Readers don't lock.
+	// Back links are used by writers only
+	uint32_t mIdNum;
+	uint32_t mHashPath;
+	PtrProc mpRegIdNext;
+	PtrProc mpRegNameNext;
+	PtrProc *mppRegNamePrev;
+	PtrProc mpRegPathNext;
+	PtrProc *mppRegPathPrev;
+#endif
+#if CONFIG_PROC_HAVE_PROFILING
+	ProcProfile mProf;
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+	ProcOverrun mOvr;
+#endif
+
+	void childAdd(Processing *pChild);
+	void childRemove(Processing *pChild);
+	void infoGet(char *pBuf, char *pBufEnd);
+#if CONFIG_PROC_HAVE_DRIVERS
+	void infoSnapshotsTake(DriverContext *pCtx);
+#endif
+
+	// Runnable children. Only touched by the driver
+	void activeAdd(Processing *pChild);
+	void activeFirstAdd(Processing *pChild);
+	void activeRemove(Processing *pChild);
+	bool activeIs() const;
+#if CONFIG_PROC_HAVE_PROFILING
+	void profileClear();
+	void profileTick();
+	void profileAdd(uint8_t idx, uint64_t durNs);
+	void profileTopCollect(Processing **pTop, size_t numTop);
+#endif
+#if CONFIG_PROC_HAVE_PROFILING || CONFIG_PROC_HAVE_WATCHDOG
+	void hookEnter(HookFrame *pFrame);
+	void hookLeave(uint8_t idx, const HookFrame *pFrame);
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+	void overrunAdd(uint8_t idx, uint64_t durNs, uint32_t budgetUs);
+#if CONFIG_PROC_HAVE_DRIVERS
+	static void watchdogSlotList();
+	static void watchdogMain();
+	static void watchdogCheck(HookSlot *pSlot, uint64_t tNowNs, uint64_t budgetNs);
+	static void watchdogStop();
+#endif
+#endif
+
+	Processing *childWeightedTick(Processing *pChild, bool &worked);
+	bool childTickFinish(Processing *pChild, bool undriven);
+#if CONFIG_PROC_HAVE_DRIVERS
+	bool childrenParallelTick(bool &worked);
 #endif
-	uint8_t mStatDrv;
 
 	/* static functions */
-	static void parentalDrive(Processing *pChild);
+	void unusedMark();
+	void successCount();
+	static void staticMark(Processing *pProc, uint16_t numChildrenMax);
+	static bool parentalDrive(Processing *pChild);
+#if CONFIG_PROC_HAVE_MIGRATION
+	static bool measuredTick(Processing *pChild) dNoInline;
+	static bool migrationMeasure(Processing *pProc, uint64_t durNs, bool parental);
+	void childMigrate(Processing *pChild);
+	static void ctxMove(Processing *pProc, DriverContext *pCtx);
+#endif
+	static bool childIdle(const Processing *pChild);
+#if CONFIG_PROC_HAVE_REGISTRY
+	static void registryAdd(Processing *pProc);
+	static void registryRemove(Processing *pProc);
+	static void registryGrow();
+	static Processing *registryFind(uint8_t idx, uint32_t hash, const char *pKey);
+	static bool pathMatch(const Processing *pProc, const char *pPath, size_t len);
+#endif
+	static void runnableSet(Processing *pProc);
+	static void wakeQueueAdd(DriverContext *pCtx, Processing *pProc);
+	static void wakeQueueProcess(DriverContext *pCtx);
+	DriverContext *ctxDriverGet();
+	static DriverContext *ctxDriverCreate(Processing *pRoot);
+	static void ctxDriverDelete(DriverContext *pCtx);
+	static bool childRetire(DriverContext *pCtx, Processing *pChild);
+	static void ctxRetire(DriverContext *pCtx, DriverContext *pCtxOld);
+	static void ctxDriverWait(DriverContext *pCtx, size_t tmoUs);
+	static void ctxDriverPark(DriverContext *pCtx, size_t tmoUs);
+	static void ctxDriverWake(DriverContext *pCtx);
+	static size_t ctxDriverBackoff(DriverContext *pCtx, bool worked);
+	static void tmrInsert(DriverContext *pCtx, Processing *pProc);
+	static void tmrRemove(Processing *pProc);
+	static void tmrAdvance(DriverContext *pCtx, uint32_t tMs);
+	static uint32_t tmrNextDelayMs(DriverContext *pCtx);
 #if CONFIG_PROC_HAVE_DRIVERS
+	static void retiredDestroy(DriverContext *pCtx, bool force);
+	static void forkJobTick(void *pArg, size_t idx);
 	static void internalDrive(void *pProc);
-	static void *driverInternalCreate(FuncInternalDrive pFctDrive, void *pProc, void *pConfigDriver);
+	static void *driverInternalCreate(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig);
+	static void *driverInternalCreateOpaque(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig);
 	static void driverInternalCleanUp(void *pDriver);
 
 	/* static variables */
 	static size_t sleepInternalDriveUs;
+	static size_t sleepReactiveDriveUs;
 	static size_t numBurstInternalDrive;
 	static FuncInternalDrive pFctInternalDrive;
 	static FuncDriverInternalCreate pFctDriverInternalCreate;
+	static FuncDriverInternalCreateOpaque pFctDriverInternalCreateOpaque;
 	static FuncDriverInternalCleanUp pFctDriverInternalCleanUp;
+	static FuncDriverInternalWakeup pFctDriverInternalWakeup;
+	static FuncForkJoin pFctForkJoin;
+#endif
+#if CONFIG_PROC_HAVE_MIGRATION
+	static uint16_t migrationHotUs;
+	static uint16_t migrationColdUs;
 #endif
 	static uint8_t showAddressInId;
 	static uint8_t disableTreeDefault;
+	static FuncProcAlloc pFctProcAlloc;
+	static FuncProcFree pFctProcFree;
 
 #if CONFIG_PROC_HAVE_GLOBAL_DESTRUCTORS
 #if CONFIG_PROC_HAVE_LIB_STD_CPP
@@ -460,16 +882,77 @@ static const char *StateName ## String[] = \
 	dForEach_ ## StateName(dGen ## StateName ## String) \
 }
 
+#if CONFIG_PROC_HAVE_TRACE
+#define dStateTraceBin() \
+	traceAdd(TeState, this, mStateOld, mState, ProcStateString[mState])
+#else
+#define dStateTraceBin()
+#endif
+
 // pst .. process state transition
 #define dStateTrace \
 if (mState != mStateOld) \
 { \
+	dStateTraceBin(); \
 	procDbgLog("pst: %s > %s", \
 			ProcStateString[mStateOld], \
 			ProcStateString[mState]); \
 	mStateOld = mState; \
 }
 
+/*
+ * Process in static memory. No allocation at runtime.
+ * Footprint is known at link time. Used on targets without heap
+ *
+ *   static ProcStatic<Supervising, 4> supervising;
+ *   static ProcStatic<Blinking, 0> blinking;
+ *
+ *   Supervising *pApp = supervising.create();
+ *   pApp->start(blinking.create(ledGreen));
+ *
+ * - create() constructs the process once. Further calls return NULL
+ * - The constructor of T must be accessible.
+ *   Use "template<typename, uint16_t> friend class ProcStatic;"
+ * - numChildrenMax is applied to the child limit of targets
+ *   without the C++ standard library
+ * - destroy() only runs the destructor
+ */
+template<typename T, uint16_t numChildrenMax = CONFIG_PROC_NUM_MAX_CHILDREN_DEFAULT>
+class ProcStatic
+{
+
+public:
+
+	ProcStatic()
+		: mpProc(NULL)
+	{}
+
+	template<typename... Args>
+	T *create(Args... args)
+	{
+		if (mpProc)
+			return NULL;
+
+		mpProc = new (mBuf) T(args...);
+		Processing::staticMark(mpProc, numChildrenMax);
+
+		return mpProc;
+	}
+
+	T *get() const { return mpProc; }
+
+	static size_t size() { return sizeof(T); }
+
+private:
+
+	ProcStatic(const ProcStatic &) = delete;
+	ProcStatic &operator=(const ProcStatic &) = delete;
+
+	alignas(T) uint8_t mBuf[sizeof(T)];
+	T *mpProc;
+
+};
+
 template <typename T>
 T PMIN(T a, T b)
 {
@@ -201,7 +201,7 @@ SystemCommanding::SystemCommanding(SOCKET fd)
 
 Success SystemCommanding::process()
 {
-	uint32_t curTimeMs = millis();
+	uint32_t curTimeMs = clockMs();
 	uint32_t diffMs = curTimeMs - mStartMs;
 	Success success;
 	//bool ok;
@@ -256,7 +256,10 @@ Success SystemCommanding::process()
 
 		success = autoCommandReceive();
 		if (success == Pending)
+		{
+			timeoutWakeupSet(cTmoCmdAuto - diffMs + 1);
 			break;
+		}
 
 		return success;
 
@@ -1442,13 +1445,6 @@ Success SystemCommanding::ansiFilter(uint8_t ch, uint16_t *pKeyOut)
 
 /* static functions */
 
-uint32_t SystemCommanding::millis()
-{
-	auto now = steady_clock::now();
-	auto nowMs = time_point_cast<milliseconds>(now);
-	return (uint32_t)nowMs.time_since_epoch().count();
-}
-
 void SystemCommanding::cmdHelpPrint(char *pArgs, char *pBuf, char *pBufEnd)
 {
 	list<SystemCommand>::iterator iter;
@@ -233,7 +233,6 @@ private:
 	char mBufOut[cSizeBufCmdOut];
 
 	/* static functions */
-	static uint32_t millis();
 	static void cmdHelpPrint(char *pArgs, char *pBuf, char *pBufEnd);
 	static void cmdHexDump(char *pArgs, char *pBuf, char *pBufEnd);
 	static size_t hexDumpPrint(char *pBuf, char *pBufEnd,
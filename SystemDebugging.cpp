@@ -132,6 +132,28 @@ Success SystemDebugging::process()
 
 		cmdReg("levelLog", &SystemDebugging::cmdLevelLogSet, "", "Set the log level for stdout", cInternalCmdCls);
 		cmdReg("levelLogSys", &SystemDebugging::cmdLevelLogSysSet, "", "Set the log level for socket", cInternalCmdCls);
+#if CONFIG_PROC_HAVE_PROFILING
+		cmdReg("profile",
+			[this](char *pArgs, char *pBuf, char *pBufEnd)
+			{
+				cmdProfile(pArgs, pBuf, pBufEnd);
+			},
+			"", "Show processes with most tick time. Argument 'reset' clears counters", cInternalCmdCls);
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+		cmdReg("overruns",
+			[this](char *pArgs, char *pBuf, char *pBufEnd)
+			{
+				cmdOverruns(pArgs, pBuf, pBufEnd);
+			},
+			"", "Show processes exceeding the tick budget. Argument 'reset' clears counters", cInternalCmdCls);
+#endif
+#if CONFIG_PROC_HAVE_TRACE
+		cmdReg("traceDump", &SystemDebugging::cmdTraceDump, "", "Dump trace events to trace.bin", cInternalCmdCls);
+#endif
+#if CONFIG_PROC_HAVE_REGISTRY
+		cmdReg("proc", &SystemDebugging::cmdProc, "", "Show process by id, name or path", cInternalCmdCls);
+#endif
 
 		entryLogCreateSet(SystemDebugging::entryLogEnqueue);
 
@@ -364,7 +386,7 @@ void SystemDebugging::processTreeSend()
 {
 	if (mProcTreeChanged)
 	{
-		uint32_t diffMs = nowMs() - mProcTreeChangedTime;
+		uint32_t diffMs = clockMs() - mProcTreeChangedTime;
 
 		if (diffMs < mUpdateMs)
 			return;
@@ -419,7 +441,7 @@ void SystemDebugging::processTreeSend()
 	mProcTree = procTree;
 
 	mProcTreeChanged = true;
-	mProcTreeChangedTime = nowMs();
+	mProcTreeChangedTime = clockMs();
 }
 
 #if CONFIG_PROC_HAVE_LOG
@@ -467,8 +489,38 @@ void SystemDebugging::logEntriesSend()
 void SystemDebugging::processInfo(char *pBuf, char *pBufEnd)
 {
 	dInfo("Update period [ms]\t\t%d\n", (int)mUpdateMs);
+	pBuf += poolsStr(pBuf, pBufEnd);
 }
 
+#if CONFIG_PROC_HAVE_PROFILING
+void SystemDebugging::cmdProfile(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	if (pArgs && !strcmp(pArgs, "reset"))
+	{
+		mpTreeRoot->profileReset();
+		dInfo("Profiling counters reset");
+		return;
+	}
+
+	mpTreeRoot->profileTopStr(pBuf, pBufEnd, 5);
+}
+#endif
+
+#if CONFIG_PROC_HAVE_WATCHDOG
+void SystemDebugging::cmdOverruns(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	if (pArgs && !strcmp(pArgs, "reset"))
+	{
+		mpTreeRoot->overrunReset();
+		dInfo("Overrun counters reset");
+		return;
+	}
+
+	if (!mpTreeRoot->overrunsStr(pBuf, pBufEnd))
+		dInfo("No overruns");
+}
+#endif
+
 /* static functions */
 void SystemDebugging::cmdLevelLogSet(char *pArgs, char *pBuf, char *pBufEnd)
 {
@@ -494,6 +546,51 @@ void SystemDebugging::cmdLevelLogSysSet(char *pArgs, char *pBuf, char *pBufEnd)
 	dInfo("System log level set to %d", lvl);
 }
 
+#if CONFIG_PROC_HAVE_TRACE
+/*
+ * The file name is fixed. Arguments of the remote
+ * command channel must not select paths
+ */
+void SystemDebugging::cmdTraceDump(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	const char *pFile = "trace.bin";
+	FILE *pStream;
+	size_t numEvents;
+
+	(void)pArgs;
+
+	pStream = fopen(pFile, "wb");
+	if (!pStream)
+	{
+		dInfo("Could not open %s", pFile);
+		return;
+	}
+
+	numEvents = Processing::traceDump(SystemDebugging::traceWrite, pStream);
+	fclose(pStream);
+
+	dInfo("%u events written to %s", (unsigned)numEvents, pFile);
+}
+
+void SystemDebugging::traceWrite(const void *pData, size_t len, void *pUser)
+{
+	fwrite(pData, 1, len, (FILE *)pUser);
+}
+#endif
+
+#if CONFIG_PROC_HAVE_REGISTRY
+void SystemDebugging::cmdProc(char *pArgs, char *pBuf, char *pBufEnd)
+{
+	if (!pArgs || !*pArgs)
+	{
+		dInfo("Usage: proc <id|name|path>");
+		return;
+	}
+
+	procStr(pBuf, pBufEnd, pArgs);
+}
+#endif
+
 static const char *tabColors[] =
 {
 	"\033[39m",   /* default */	"\033[0;31m", /* red */		"\033[0;33m", /* yellow */
@@ -157,6 +157,12 @@ private:
 	void logEntriesSend();
 #endif
 	void processInfo(char *pBuf, char *pBufEnd);
+#if CONFIG_PROC_HAVE_PROFILING
+	void cmdProfile(char *pArgs, char *pBuf, char *pBufEnd);
+#endif
+#if CONFIG_PROC_HAVE_WATCHDOG
+	void cmdOverruns(char *pArgs, char *pBuf, char *pBufEnd);
+#endif
 
 	/* member variables */
 	Processing *mpTreeRoot;
@@ -179,6 +185,13 @@ private:
 
 	/* static functions */
 	static void cmdLevelLogSet(char *pArgs, char *pBuf, char *pBufEnd);
+#if CONFIG_PROC_HAVE_TRACE
+	static void cmdTraceDump(char *pArgs, char *pBuf, char *pBufEnd);
+	static void traceWrite(const void *pData, size_t len, void *pUser);
+#endif
+#if CONFIG_PROC_HAVE_REGISTRY
+	static void cmdProc(char *pArgs, char *pBuf, char *pBufEnd);
+#endif
 	static void cmdLevelLogSysSet(char *pArgs, char *pBuf, char *pBufEnd);
 	static void procTreeDetailedToggle(char *pArgs, char *pBuf, char *pBufEnd);
 	static void procTreeColoredToggle(char *pArgs, char *pBuf, char *pBufEnd);
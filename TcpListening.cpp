@@ -140,7 +140,7 @@ Success TcpListening::process()
 	case StMain:
 
 		++mCntSkip;
-		if (mCntSkip < dCntSkipMax)
+		if (mCntSkip < dCntSkipMax && !fdEventsReceived())
 			return Pending;
 		mCntSkip = 0;
 
@@ -276,7 +276,9 @@ Success TcpListening::socketCreate(bool isIPv6, SOCKET &fdLst, string &strAddr)
 
 	if (::listen(fdLst, 8192) < 0)
 		return procErrLog(-1, "listen() failed: %s", errnoToStr(errGet()).c_str());
-
+#ifndef _WIN32
+	fdEventsAdd(fdLst);
+#endif
 	return Positive;
 }
 
@@ -132,7 +132,7 @@ TcpTransfering::TcpTransfering(const string &hostAddr, uint16_t hostPort)
  */
 Success TcpTransfering::process()
 {
-	uint32_t curTimeMs = millis();
+	uint32_t curTimeMs = clockMs();
 	uint32_t diffMs = curTimeMs - mStartMs;
 	Success success;
 	int res, numErr = 0;
@@ -229,7 +229,10 @@ Success TcpTransfering::process()
 
 		success = connClientDone();
 		if (success == Pending)
+		{
+			timeoutWakeupSet(dTmoDefaultConnDoneMs - diffMs + 1);
 			break;
+		}
 
 		if (success != Positive)
 			return procErrLog(-1, "client connect failed");
@@ -480,6 +483,7 @@ void TcpTransfering::disconnect(int err)
 #ifdef _WIN32
 	::closesocket(mSocketFd);
 #else
+	fdEventsRemove(mSocketFd);
 	::close(mSocketFd);
 #endif
 	mSocketFd = INVALID_SOCKET;
@@ -505,7 +509,10 @@ Success TcpTransfering::socketOptionsSet()
 	if (!ok)
 		return procErrLog(-3, "could not set non blocking mode: %s",
 							errnoToStr(errGet()).c_str());
-
+#ifndef _WIN32
+	// Writable: Used by clients for connect()
+	fdEventsAdd(mSocketFd, true);
+#endif
 	mReadReady = true;
 
 	return Positive;
@@ -750,13 +757,6 @@ bool TcpTransfering::sockaddrInfoGet(struct sockaddr_storage &addr,
 	return true;
 }
 
-uint32_t TcpTransfering::millis()
-{
-	auto now = steady_clock::now();
-	auto nowMs = time_point_cast<milliseconds>(now);
-	return (uint32_t)nowMs.time_since_epoch().count();
-}
-
 bool TcpTransfering::fileNonBlockingSet(SOCKET fd)
 {
 	int opt;
@@ -199,7 +199,6 @@ private:
 	size_t mBytesSent;
 
 	/* static functions */
-	static uint32_t millis();
 	static bool fileNonBlockingSet(SOCKET fd);
 #ifdef _WIN32
 	static void globalWsaDestruct();
@@ -0,0 +1,560 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "ThreadPooling.h"
+
+#if CONFIG_PROC_HAVE_DRIVERS
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <condition_variable>
+
+using namespace std;
+
+/*
+ * Jobs of internal drivers are released by the worker and
+ * by driverCleanUp(). The second one deletes the job
+ */
+struct PoolJob
+{
+	Processing *pProc;
+	atomic<bool> released;
+	bool deleteWhenDone;
+};
+
+// Lives on the stack of the forking thread
+struct PoolFork
+{
+	FuncForkJob pFctJob;
+	void *pArg;
+	size_t numJobs;
+	atomic<size_t> idxNext;
+	atomic<size_t> numDone;
+	size_t numHelpers;
+};
+
+struct PoolWorker
+{
+	mutex mtxJobs;
+	deque<PoolJob *> jobs;
+	thread *pThread;
+};
+
+static vector<PoolWorker *> workers;
+static mutex mtxWorkers;
+static atomic<bool> poolRunning(false);
+static atomic<size_t> idxWorkerNext(0);
+static atomic<size_t> cntJobs(0);
+static size_t sleepPoolUs = 2000;
+static size_t numBurstPool = 13;
+static bool globDestrRegistered = false;
+static deque<PoolFork *> forks;
+static mutex mtxForks;
+static condition_variable cvForks;
+static atomic<size_t> cntForks(0);
+static bool wakeupPool = false;
+
+/* Literature
+ * - https://en.wikipedia.org/wiki/Work_stealing
+ * - https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf
+ */
+
+static PoolJob *jobPop(PoolWorker *pWorker)
+{
+	Guard lock(pWorker->mtxJobs);
+
+	if (pWorker->jobs.empty())
+		return NULL;
+
+	PoolJob *pJob = pWorker->jobs.front();
+	pWorker->jobs.pop_front();
+
+	return pJob;
+}
+
+static PoolJob *jobSteal(size_t idxThief)
+{
+	size_t numWorkers = workers.size();
+	PoolWorker *pVictim;
+	PoolJob *pJob;
+
+	for (size_t i = 1; i < numWorkers; ++i)
+	{
+		pVictim = workers[(idxThief + i) % numWorkers];
+
+		Guard lock(pVictim->mtxJobs);
+
+		if (pVictim->jobs.empty())
+			continue;
+
+		pJob = pVictim->jobs.back();
+		pVictim->jobs.pop_back();
+
+		return pJob;
+	}
+
+	return NULL;
+}
+
+static void forkJobsExecute(PoolFork *pFork)
+{
+	size_t idx;
+
+	while (1)
+	{
+		idx = pFork->idxNext.fetch_add(1);
+		if (idx >= pFork->numJobs)
+			break;
+
+		pFork->pFctJob(pFork->pArg, idx);
+		pFork->numDone.fetch_add(1, memory_order_release);
+	}
+}
+
+// Sleeping workers are woken up by new jobs and wakeups of processes
+static void workersWakeup()
+{
+	{
+		Guard lock(mtxForks);
+		wakeupPool = true;
+	}
+
+	cvForks.notify_all();
+}
+
+/*
+ * Return: False if the job leaves the pool. Processes started
+ * with DrivenByNewInternalDriver may also leave by a migration
+ */
+static bool jobTick(PoolJob *pJob, bool &worked)
+{
+	Processing *pProc = pJob->pProc;
+
+	if (!pJob->deleteWhenDone)
+		return Processing::internalTick(pProc, worked);
+
+	worked = pProc->treeTick();
+
+	if (pProc->progress())
+		return true;
+
+	Processing::undrivenSet(pProc);
+	return false;
+}
+
+static void jobRelease(PoolJob *pJob)
+{
+	if (pJob->deleteWhenDone)
+	{
+		delete pJob;
+		return;
+	}
+
+	if (pJob->released.exchange(true, memory_order_acq_rel))
+		delete pJob;
+}
+
+static void poolStop()
+{
+	if (!poolRunning)
+		return;
+
+	poolRunning = false;
+
+	vector<PoolWorker *>::iterator iter;
+
+	iter = workers.begin();
+	for (; iter != workers.end(); ++iter)
+	{
+		thread *pThread = (*iter)->pThread;
+
+		if (!pThread)
+			continue;
+
+		if (pThread->joinable())
+			pThread->join();
+
+		delete pThread;
+		(*iter)->pThread = NULL;
+	}
+
+	iter = workers.begin();
+	for (; iter != workers.end(); ++iter)
+	{
+		PoolWorker *pWorker = *iter;
+
+		while (!pWorker->jobs.empty())
+		{
+			jobRelease(pWorker->jobs.front());
+			pWorker->jobs.pop_front();
+			--cntJobs;
+		}
+
+		delete pWorker;
+	}
+
+	workers.clear();
+}
+
+bool ThreadPooling::start(size_t numWorkers)
+{
+	Guard lock(mtxWorkers);
+
+	if (poolRunning)
+		return true;
+
+	if (!numWorkers)
+		numWorkers = thread::hardware_concurrency();
+
+	if (!numWorkers)
+		numWorkers = 1;
+
+	for (size_t i = 0; i < numWorkers; ++i)
+	{
+		PoolWorker *pWorker = new dNoThrow PoolWorker;
+		if (!pWorker)
+			break;
+
+		pWorker->pThread = NULL;
+		workers.push_back(pWorker);
+	}
+
+	if (workers.size() != numWorkers)
+	{
+		poolRunning = true;
+		poolStop();
+
+		errLog(-1, "could not allocate workers");
+		return false;
+	}
+
+	poolRunning = true;
+
+	for (size_t i = 0; i < numWorkers; ++i)
+	{
+		workers[i]->pThread = new dNoThrow thread(workerDrive, i);
+		if (workers[i]->pThread)
+			continue;
+
+		poolStop();
+
+		errLog(-2, "could not create worker thread");
+		return false;
+	}
+
+	if (!globDestrRegistered)
+	{
+		Processing::globalDestructorRegister(ThreadPooling::stop);
+		globDestrRegistered = true;
+	}
+
+	dbgLog("thread pool started with %d workers", (int)numWorkers);
+
+	return true;
+}
+
+void ThreadPooling::stop()
+{
+	Guard lock(mtxWorkers);
+	poolStop();
+}
+
+void ThreadPooling::driversInternalReplace()
+{
+	Processing::driverInternalCreateAndCleanUpSet(driverCreate, driverCleanUp);
+	Processing::driverInternalWakeupSet(driverWakeup);
+}
+
+bool ThreadPooling::procDrive(Processing *pProc)
+{
+	return jobAdd(pProc, true) != NULL;
+}
+
+void ThreadPooling::forkJoinReplace()
+{
+	Processing::forkJoinSet(forkJoin);
+}
+
+void ThreadPooling::sleepUsSet(size_t delayUs)
+{
+	sleepPoolUs = delayUs;
+}
+
+void ThreadPooling::numBurstSet(size_t numBurst)
+{
+	if (!numBurst)
+		return;
+
+	numBurstPool = numBurst;
+}
+
+size_t ThreadPooling::numWorkers()
+{
+	Guard lock(mtxWorkers);
+	return workers.size();
+}
+
+size_t ThreadPooling::numJobs()
+{
+	return cntJobs;
+}
+
+/*
+ * Workers are shared. Configuration of drivers is not applied.
+ * The drive function is replaced by the workers. They use
+ * Processing::internalTick() which includes migrations
+ */
+void *ThreadPooling::driverCreate(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig)
+{
+	(void)pFctDrive;
+
+	if (pConfig)
+		wrnLog("configuration of drivers not supported by thread pool");
+
+	return jobAdd((Processing *)pProc, false);
+}
+
+// Parent doesn't wait for the worker to release the job
+void ThreadPooling::driverCleanUp(void *pDriver)
+{
+	jobRelease((PoolJob *)pDriver);
+}
+
+void ThreadPooling::driverWakeup(void *pProc)
+{
+	(void)pProc;
+	workersWakeup();
+}
+
+/*
+ * The forking thread executes jobs as well. All jobs
+ * are therefore done even if no worker is available
+ */
+void ThreadPooling::forkJoin(FuncForkJob pFctJob, void *pArg, size_t numJobs)
+{
+	PoolFork fork;
+
+	fork.pFctJob = pFctJob;
+	fork.pArg = pArg;
+	fork.numJobs = numJobs;
+	fork.idxNext = 0;
+	fork.numDone = 0;
+	fork.numHelpers = 0;
+
+	if (numJobs < 2 || (!poolRunning && !start()))
+	{
+		forkJobsExecute(&fork);
+		return;
+	}
+
+	{
+		Guard lock(mtxForks);
+		forks.push_back(&fork);
+		++cntForks;
+	}
+
+	cvForks.notify_all();
+
+	forkJobsExecute(&fork);
+
+	while (fork.numDone.load(memory_order_acquire) < numJobs)
+		this_thread::yield();
+
+	{
+		Guard lock(mtxForks);
+
+		deque<PoolFork *>::iterator iter = forks.begin();
+
+		for (; iter != forks.end(); ++iter)
+		{
+			if (*iter != &fork)
+				continue;
+
+			forks.erase(iter);
+			--cntForks;
+			break;
+		}
+	}
+
+	// Helpers may still hold the fork
+	while (1)
+	{
+		{
+			Guard lock(mtxForks);
+
+			if (!fork.numHelpers)
+				break;
+		}
+
+		this_thread::yield();
+	}
+}
+
+/* static functions */
+
+void *ThreadPooling::jobAdd(Processing *pProc, bool deleteWhenDone)
+{
+	if (!pProc)
+		return NULL;
+
+	if (!poolRunning && !start())
+		return NULL;
+
+	PoolJob *pJob = new dNoThrow PoolJob;
+	if (!pJob)
+		return NULL;
+
+	pJob->pProc = pProc;
+	pJob->released = false;
+	pJob->deleteWhenDone = deleteWhenDone;
+
+	Guard lock(mtxWorkers);
+
+	if (workers.empty())
+	{
+		delete pJob;
+		return NULL;
+	}
+
+	PoolWorker *pWorker = workers[idxWorkerNext++ % workers.size()];
+	{
+		Guard lockJobs(pWorker->mtxJobs);
+		pWorker->jobs.push_back(pJob);
+	}
+
+	++cntJobs;
+
+	workersWakeup();
+
+	return pJob;
+}
+
+void ThreadPooling::workerDrive(size_t idxWorker)
+{
+	PoolWorker *pSelf = workers[idxWorker];
+	PoolJob *pJob;
+	size_t numRound, i, k;
+	bool worked, workedTick, driven;
+
+	while (poolRunning)
+	{
+		worked = false;
+
+		if (cntForks && forkHelp())
+			worked = true;
+
+		{
+			Guard lock(pSelf->mtxJobs);
+			numRound = pSelf->jobs.size();
+		}
+
+		// Empty deque => Try to steal one job
+		if (!numRound)
+			numRound = 1;
+
+		for (i = 0; i < numRound; ++i)
+		{
+			// Forking parents are waiting
+			if (cntForks && forkHelp())
+				worked = true;
+
+			pJob = jobPop(pSelf);
+			if (!pJob)
+				pJob = jobSteal(idxWorker);
+			if (!pJob)
+				break;
+
+			driven = true;
+
+			for (k = 0; driven && k < numBurstPool; ++k)
+			{
+				driven = jobTick(pJob, workedTick);
+				if (workedTick)
+					worked = true;
+			}
+
+			if (driven)
+			{
+				Guard lock(pSelf->mtxJobs);
+				pSelf->jobs.push_back(pJob);
+				continue;
+			}
+
+			--cntJobs;
+
+			jobRelease(pJob);
+		}
+
+		// Sleep only if none of the processes did some work
+		if (worked || !sleepPoolUs)
+			continue;
+
+		unique_lock<mutex> lock(mtxForks);
+
+		if (!cntForks && !wakeupPool)
+			cvForks.wait_for(lock, chrono::microseconds(sleepPoolUs));
+
+		wakeupPool = false;
+	}
+}
+
+// Return: True if jobs of a fork have been executed
+bool ThreadPooling::forkHelp()
+{
+	PoolFork *pFork = NULL;
+
+	{
+		Guard lock(mtxForks);
+
+		deque<PoolFork *>::iterator iter = forks.begin();
+
+		for (; iter != forks.end(); ++iter)
+		{
+			if ((*iter)->idxNext >= (*iter)->numJobs)
+				continue;
+
+			pFork = *iter;
+			++pFork->numHelpers;
+			break;
+		}
+	}
+
+	if (!pFork)
+		return false;
+
+	forkJobsExecute(pFork);
+
+	Guard lock(mtxForks);
+	--pFork->numHelpers;
+
+	return true;
+}
+#endif
+
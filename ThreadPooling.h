@@ -0,0 +1,93 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef THREAD_POOLING_H
+#define THREAD_POOLING_H
+
+#include "Processing.h"
+
+/*
+  What is ThreadPooling?
+  - A fixed number of worker threads, usually one per core
+  - Each worker owns a deque of driven processes
+  - Idle workers steal processes from the back of other deques
+  - Can be used in two ways
+    - driversInternalReplace() .. Processes started with
+                                  DrivenByNewInternalDriver are
+                                  driven by the pool instead of
+                                  a new thread each
+    - procDrive()              .. Drive a process which has been
+                                  started with DrivenByExternalDriver
+    - forkJoinReplace()        .. Parallel safe siblings are ticked
+                                  by the workers. See parallelSet()
+  - Finished processes are marked as undriven and leave the pool.
+    Migrated processes leave the pool as well
+*/
+
+#if CONFIG_PROC_HAVE_DRIVERS
+class ThreadPooling
+{
+
+public:
+
+	static bool start(size_t numWorkers = 0);
+	static void stop();
+
+	static void driversInternalReplace();
+	static bool procDrive(Processing *pProc);
+	static void forkJoinReplace();
+
+	static void sleepUsSet(size_t delayUs);
+	static void numBurstSet(size_t numBurst);
+
+	static size_t numWorkers();
+	static size_t numJobs();
+
+	static void *driverCreate(FuncInternalDrive pFctDrive, void *pProc, const ConfigDriver *pConfig);
+	static void driverCleanUp(void *pDriver);
+	static void driverWakeup(void *pProc);
+	static void forkJoin(FuncForkJob pFctJob, void *pArg, size_t numJobs);
+
+private:
+
+	ThreadPooling() {}
+	ThreadPooling(const ThreadPooling &) {}
+	ThreadPooling &operator=(const ThreadPooling &) { return *this; }
+
+	/* static functions */
+	static void *jobAdd(Processing *pProc, bool deleteWhenDone);
+	static void workerDrive(size_t idxWorker);
+	static bool forkHelp();
+
+};
+#endif
+
+#endif
+
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+
+# Compares two result files of benchmarking --json.
+# Lower is better except for throughput units (per second).
+# Changes above the threshold are marked.
+#
+# Usage: compare.py old.json new.json [thresholdPercent]
+
+import sys
+import json
+
+def resultsRead(fileName):
+
+	res = {}
+
+	with open(fileName) as f:
+		for line in f:
+			line = line.strip()
+			if not line.startswith('{'):
+				continue
+
+			r = json.loads(line)
+			key = (r['case'], r['param'], r['unitParam'], r['unit'])
+			res[key] = r['value']
+
+	return res
+
+def higherIsBetter(unit):
+	return unit.endswith('/s')
+
+if __name__ == '__main__':
+
+	if len(sys.argv) < 3:
+		print('Usage: %s old.json new.json [thresholdPercent]' % sys.argv[0])
+		sys.exit(1)
+
+	threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+
+	resOld = resultsRead(sys.argv[1])
+	resNew = resultsRead(sys.argv[2])
+	numWorse = 0
+
+	for key, valNew in resNew.items():
+		nameCase, param, unitParam, unit = key
+
+		if key not in resOld:
+			print('%-8s %8d %-10s %14.2f %-12s new' % (nameCase, param, unitParam, valNew, unit))
+			continue
+
+		valOld = resOld[key]
+		change = (valNew - valOld) / valOld * 100.0 if valOld else 0.0
+
+		if higherIsBetter(unit):
+			change = -change
+
+		mark = ''
+		if change > threshold:
+			mark = 'WORSE'
+			numWorse += 1
+		elif change < -threshold:
+			mark = 'better'
+
+		print('%-8s %8d %-10s %14.2f %-12s %+7.1f %% %s' %
+				(nameCase, param, unitParam, valNew, unit, change, mark))
+
+	sys.exit(1 if numWorse else 0)
+
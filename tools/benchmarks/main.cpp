@@ -0,0 +1,772 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "Processing.h"
+#include "Pipe.h"
+#include "TcpTransfering.h"
+#include "TcpListening.h"
+#include "SystemCommanding.h"
+#include "SystemDebugging.h"
+#if CONFIG_PROC_HAVE_COROUTINES
+#include "Coroutining.h"
+#endif
+
+using namespace std;
+using namespace chrono;
+
+/*
+ * Benchmarks of the process tree core.
+ * Build in release mode. Console logs are filtered.
+ *
+ * Usage: benchmarking [--json] [case ...]
+ * - Without cases all cases are run
+ * - With --json each result is printed as one JSON object per line
+ */
+
+static size_t numLeafsAlive = 0;
+static size_t numNodesAlive = 0;
+static bool outJson = false;
+static int numCases = 0;
+static char **pCases = NULL;
+
+class LeafBenching : public Processing
+{
+
+public:
+
+	static LeafBenching *create(bool finishing, bool idling)
+	{
+		return new dNoThrow LeafBenching(finishing, idling);
+	}
+
+protected:
+
+	LeafBenching(bool finishing, bool idling)
+		: Processing("LeafBenching")
+		, mFinishing(finishing)
+		, mIdling(idling)
+	{
+		procTreeDisplaySet(false);
+		++numLeafsAlive;
+	}
+
+	virtual ~LeafBenching()
+	{
+		--numLeafsAlive;
+	}
+
+private:
+
+	LeafBenching() = delete;
+	LeafBenching(const LeafBenching &) = delete;
+	LeafBenching &operator=(const LeafBenching &) = delete;
+
+	Success process()
+	{
+		if (mIdling)
+			idleSet();
+
+		return mFinishing ? Positive : Pending;
+	}
+
+	bool mFinishing;
+	bool mIdling;
+
+};
+
+class TreeBenching : public Processing
+{
+
+public:
+
+	static TreeBenching *create()
+	{
+		return new dNoThrow TreeBenching;
+	}
+
+	bool leafsStart(size_t numLeafs, bool finishing, bool idling = false)
+	{
+		LeafBenching *pLeaf;
+
+		for (size_t i = 0; i < numLeafs; ++i)
+		{
+			pLeaf = LeafBenching::create(finishing, idling);
+			if (!pLeaf)
+				return false;
+
+			start(pLeaf);
+
+			if (finishing)
+				whenFinishedRepel(pLeaf);
+		}
+
+		return true;
+	}
+
+	Processing *childStart(Processing *pChild)
+	{
+		return start(pChild);
+	}
+
+protected:
+
+	TreeBenching()
+		: Processing("TreeBenching")
+	{}
+
+	virtual ~TreeBenching() {}
+
+private:
+
+	TreeBenching(const TreeBenching &) = delete;
+	TreeBenching &operator=(const TreeBenching &) = delete;
+
+	Success process()
+	{
+		return Pending;
+	}
+
+};
+
+// Busy node which starts fanOut children until depth is reached
+class NodeBenching : public Processing
+{
+
+public:
+
+	static NodeBenching *create(size_t depth, size_t fanOut, bool displayed = false)
+	{
+		return new dNoThrow NodeBenching(depth, fanOut, displayed);
+	}
+
+protected:
+
+	NodeBenching(size_t depth, size_t fanOut, bool displayed)
+		: Processing("NodeBenching")
+		, mDepth(depth)
+		, mFanOut(fanOut)
+		, mDisplayed(displayed)
+		, mStarted(false)
+	{
+		procTreeDisplaySet(displayed);
+		++numNodesAlive;
+	}
+
+	virtual ~NodeBenching()
+	{
+		--numNodesAlive;
+	}
+
+private:
+
+	NodeBenching() = delete;
+	NodeBenching(const NodeBenching &) = delete;
+	NodeBenching &operator=(const NodeBenching &) = delete;
+
+	Success process()
+	{
+		if (!mDepth || mStarted)
+			return Pending;
+
+		NodeBenching *pChild;
+
+		for (size_t i = 0; i < mFanOut; ++i)
+		{
+			pChild = create(mDepth - 1, mFanOut, mDisplayed);
+			if (!pChild)
+				return -1;
+
+			start(pChild);
+		}
+
+		mStarted = true;
+
+		return Pending;
+	}
+
+	size_t mDepth;
+	size_t mFanOut;
+	bool mDisplayed;
+	bool mStarted;
+
+};
+
+static bool caseEnabled(const char *nameCase)
+{
+	if (!numCases)
+		return true;
+
+	for (int i = 0; i < numCases; ++i)
+	{
+		if (!strcmp(pCases[i], nameCase))
+			return true;
+	}
+
+	return false;
+}
+
+static void resultPrint(const char *nameCase, size_t param,
+				const char *unitParam, double val, const char *unitVal)
+{
+	if (outJson)
+	{
+		printf("{\"case\":\"%s\",\"param\":%zu,\"unitParam\":\"%s\","
+				"\"value\":%.2f,\"unit\":\"%s\"}\n",
+				nameCase, param, unitParam, val, unitVal);
+		fflush(stdout);
+		return;
+	}
+
+	printf("%-16s %8zu %-10s %14.2f %s\n",
+			nameCase, param, unitParam, val, unitVal);
+	fflush(stdout);
+}
+
+static double nsPer(steady_clock::time_point tStart, size_t cnt)
+{
+	double ns = (double)duration_cast<nanoseconds>(steady_clock::now() - tStart).count();
+
+	return cnt ? ns / (double)cnt : 0.0;
+}
+
+static void treeFinish(Processing *pTree)
+{
+	pTree->unusedSet();
+
+	while (pTree->progress())
+		pTree->treeTick();
+
+	Processing::destroy(pTree);
+}
+
+// Ticking a tree of busy or idle children
+static bool tickBench(size_t numLeafs, size_t numTicks, bool idling)
+{
+	TreeBenching *pTree = TreeBenching::create();
+	if (!pTree)
+		return false;
+
+	pTree->treeTick();
+
+	if (!pTree->leafsStart(numLeafs, false, idling))
+		return false;
+
+	// Leafs are initialized during the first ticks
+	pTree->treeTick();
+	pTree->treeTick();
+	pTree->treeTick();
+
+	steady_clock::time_point tStart = steady_clock::now();
+
+	for (size_t i = 0; i < numTicks; ++i)
+		pTree->treeTick();
+
+	double nsTick = nsPer(tStart, numTicks);
+	const char *nameCase = idling ? "idle" : "tick";
+
+	resultPrint(nameCase, numLeafs, "children", nsTick, "ns/tick");
+	resultPrint(nameCase, numLeafs, "children", nsTick / (double)numLeafs, "ns/child");
+
+	treeFinish(pTree);
+
+	return true;
+}
+
+static size_t numNodesTree(size_t depth, size_t fanOut)
+{
+	size_t numNodes = 1, numLevel = 1;
+
+	for (size_t i = 0; i < depth; ++i)
+	{
+		numLevel *= fanOut;
+		numNodes += numLevel;
+	}
+
+	return numNodes;
+}
+
+static NodeBenching *treeBuild(size_t depth, size_t fanOut, bool displayed = false)
+{
+	size_t numNodes = numNodesTree(depth, fanOut);
+
+	NodeBenching *pTree = NodeBenching::create(depth, fanOut, displayed);
+	if (!pTree)
+		return NULL;
+
+	// Deep trees are built one level per few ticks
+	while (numNodesAlive < numNodes && pTree->progress())
+		pTree->treeTick();
+
+	for (size_t i = 0; i < depth + 3; ++i)
+		pTree->treeTick();
+
+	return pTree;
+}
+
+// Ticking busy trees of different shapes
+static bool shapeBench(const char *nameCase, size_t depth, size_t fanOut, size_t numTicks)
+{
+	size_t numNodes = numNodesTree(depth, fanOut);
+
+	NodeBenching *pTree = treeBuild(depth, fanOut);
+	if (!pTree)
+		return false;
+
+	steady_clock::time_point tStart = steady_clock::now();
+
+	for (size_t i = 0; i < numTicks; ++i)
+		pTree->treeTick();
+
+	double nsTick = nsPer(tStart, numTicks);
+
+	resultPrint(nameCase, numNodes, "nodes", nsTick / (double)numNodes, "ns/node");
+
+	treeFinish(pTree);
+
+	return true;
+}
+
+// Starting, finishing and removing children
+static bool churnBench(size_t numLeafs, size_t numRounds)
+{
+	TreeBenching *pTree = TreeBenching::create();
+	if (!pTree)
+		return false;
+
+	pTree->treeTick();
+
+	steady_clock::time_point tStart = steady_clock::now();
+
+	for (size_t i = 0; i < numRounds; ++i)
+	{
+		if (!pTree->leafsStart(numLeafs, true))
+			return false;
+
+		while (numLeafsAlive)
+			pTree->treeTick();
+	}
+
+	double nsChild = nsPer(tStart, numLeafs * numRounds);
+
+	resultPrint("churn", numLeafs, "children", nsChild, "ns/child");
+
+	treeFinish(pTree);
+
+	return true;
+}
+
+/*
+ * Committing particles to a pipe and pushing them to its children.
+ * Without children the particles are fetched from the pipe directly
+ */
+static bool pipeBench(size_t numChildren, size_t numParticles)
+{
+	const size_t sizeBatch = 64;
+	Pipe<uint32_t> ppRoot(sizeBatch);
+	Pipe<uint32_t> *ppChildren[16];
+	PipeEntry<uint32_t> entry;
+	uint32_t sum = 0;
+
+	if (numChildren > sizeof(ppChildren) / sizeof(ppChildren[0]))
+		return false;
+
+	for (size_t i = 0; i < numChildren; ++i)
+	{
+		ppChildren[i] = new dNoThrow Pipe<uint32_t>(sizeBatch);
+		if (!ppChildren[i])
+			return false;
+
+		ppRoot.connect(ppChildren[i]);
+	}
+
+	steady_clock::time_point tStart = steady_clock::now();
+
+	for (size_t n = 0; n < numParticles; n += sizeBatch)
+	{
+		for (size_t i = 0; i < sizeBatch; ++i)
+			ppRoot.commit(uint32_t(n + i));
+
+		if (!numChildren)
+		{
+			while (ppRoot.get(entry) > 0)
+				sum += entry.particle;
+
+			continue;
+		}
+
+		ppRoot.toPushTry();
+
+		for (size_t i = 0; i < numChildren; ++i)
+		{
+			while (ppChildren[i]->get(entry) > 0)
+				sum += entry.particle;
+		}
+	}
+
+	double nsParticle = nsPer(tStart, numParticles);
+
+	resultPrint("pipe", numChildren, "children", nsParticle, "ns/particle");
+
+	for (size_t i = 0; i < numChildren; ++i)
+	{
+		ppRoot.disconnect(ppChildren[i]);
+		delete ppChildren[i];
+	}
+
+	return sum != 1;
+}
+
+/*
+ * Rendering the process tree as used by SystemDebugging.
+ * Hidden nodes are only walked. Up to 11 children are drawn per node
+ */
+static bool renderBench(const char *nameCase, size_t depth, size_t fanOut,
+				bool displayed, size_t numRenders)
+{
+	size_t numNodes = numNodesTree(depth, fanOut);
+	size_t sizeBuf = (numNodes + 1) * 256;
+	char *pBuf = new dNoThrow char[sizeBuf];
+	if (!pBuf)
+		return false;
+
+	NodeBenching *pTree = treeBuild(depth, fanOut, displayed);
+	if (!pTree)
+	{
+		delete[] pBuf;
+		return false;
+	}
+
+	// Root is always drawn
+	pTree->procTreeDisplaySet(true);
+
+	size_t len = 0;
+	steady_clock::time_point tStart = steady_clock::now();
+
+	for (size_t i = 0; i < numRenders; ++i)
+		len += pTree->processTreeStr(pBuf, pBuf + sizeBuf);
+
+	double nsRender = nsPer(tStart, numRenders);
+
+	resultPrint(nameCase, numNodes, "nodes", nsRender, "ns/render");
+	resultPrint(nameCase, numNodes, "nodes", nsRender / (double)numNodes, "ns/node");
+
+	treeFinish(pTree);
+	delete[] pBuf;
+
+	return len > 0;
+}
+
+static void entryLogDiscard(
+			const int severity,
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+			const char *pTimeAbs,
+			const system_clock::time_point &tLogged,
+#endif
+			const char *pTimeCnt,
+			const char *pWhere,
+			const char *pSeverity,
+			const char *pWhatUser)
+{
+	(void)severity;
+#if CONFIG_PROC_LOG_HAVE_CHRONO
+	(void)pTimeAbs;
+	(void)tLogged;
+#endif
+	(void)pTimeCnt;
+	(void)pWhere;
+	(void)pSeverity;
+	(void)pWhatUser;
+}
+
+// Creating log entries. Console output is filtered
+static bool logBench(size_t numEntries)
+{
+	int levelBkup = levelLogGet();
+
+	levelLogSet(0);
+	entryLogCreateSet(entryLogDiscard);
+
+	for (int severity = 1; severity <= 5; ++severity)
+	{
+		steady_clock::time_point tStart = steady_clock::now();
+
+		for (size_t i = 0; i < numEntries; ++i)
+			entryLogCreate(severity, NULL, "main.cpp", __func__, __LINE__, 0, "Entry %zu", i);
+
+		resultPrint("log", size_t(severity), "severity", nsPer(tStart, numEntries), "ns/entry");
+	}
+
+	entryLogCreateSet(NULL);
+	levelLogSet(levelBkup);
+
+	return true;
+}
+
+#ifndef _WIN32
+static bool tcpPairCreate(SOCKET &fdA, SOCKET &fdB)
+{
+	struct sockaddr_in addr;
+	socklen_t lenAddr = sizeof(addr);
+	SOCKET fdLst;
+	int res;
+
+	fdLst = socket(AF_INET, SOCK_STREAM, 0);
+	if (fdLst == INVALID_SOCKET)
+		return false;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+
+	res = ::bind(fdLst, (struct sockaddr *)&addr, sizeof(addr));
+	if (!res)
+		res = ::listen(fdLst, 1);
+	if (!res)
+		res = ::getsockname(fdLst, (struct sockaddr *)&addr, &lenAddr);
+	if (res)
+	{
+		::close(fdLst);
+		return false;
+	}
+
+	fdA = socket(AF_INET, SOCK_STREAM, 0);
+	if (fdA == INVALID_SOCKET)
+	{
+		::close(fdLst);
+		return false;
+	}
+
+	res = ::connect(fdA, (struct sockaddr *)&addr, sizeof(addr));
+	if (!res)
+		fdB = ::accept(fdLst, NULL, NULL);
+
+	::close(fdLst);
+
+	if (res || fdB == INVALID_SOCKET)
+	{
+		::close(fdA);
+		return false;
+	}
+
+	return true;
+}
+
+// Loopback throughput and round trip time of TcpTransfering
+static bool tcpBench(size_t sizeBlock, size_t numBytes, size_t numRoundTrips)
+{
+	SOCKET fdA, fdB = INVALID_SOCKET;
+	TcpTransfering *pA, *pB;
+	TreeBenching *pTree;
+	char *pBuf;
+	ssize_t res;
+
+	if (!tcpPairCreate(fdA, fdB))
+		return false;
+
+	pTree = TreeBenching::create();
+	pA = TcpTransfering::create(fdA);
+	pB = TcpTransfering::create(fdB);
+	pBuf = new dNoThrow char[sizeBlock];
+
+	if (!pTree || !pA || !pB || !pBuf)
+		return false;
+
+	pTree->childStart(pA);
+	pTree->childStart(pB);
+
+	while (!pA->mReadReady || !pB->mReadReady)
+		pTree->treeTick();
+
+	memset(pBuf, 0x55, sizeBlock);
+
+	size_t numSent = 0, numRcvd = 0;
+	steady_clock::time_point tStart = steady_clock::now();
+
+	while (numRcvd < numBytes)
+	{
+		if (numSent < numBytes && numSent - numRcvd < sizeBlock)
+		{
+			res = pA->send(pBuf, sizeBlock);
+			if (res < 0)
+				return false;
+
+			numSent += size_t(res);
+		}
+
+		res = pB->read(pBuf, sizeBlock);
+		if (res < 0)
+			return false;
+
+		numRcvd += size_t(res);
+	}
+
+	double nsByte = nsPer(tStart, numRcvd);
+
+	resultPrint("tcp", sizeBlock, "bytes", 1000.0 / nsByte, "MB/s");
+
+	tStart = steady_clock::now();
+
+	for (size_t i = 0; i < numRoundTrips; ++i)
+	{
+		if (pA->send(pBuf, 1) != 1)
+			return false;
+
+		while (!(res = pB->read(pBuf, 1)));
+		if (res != 1)
+			return false;
+
+		if (pB->send(pBuf, 1) != 1)
+			return false;
+
+		while (!(res = pA->read(pBuf, 1)));
+		if (res != 1)
+			return false;
+	}
+
+	resultPrint("tcp", 1, "bytes", nsPer(tStart, numRoundTrips), "ns/roundtrip");
+
+	delete[] pBuf;
+	treeFinish(pTree);
+
+	return true;
+}
+#endif
+
+/*
+ * Footprint of the process classes. Known at build time.
+ * Only the object itself. Buffers allocated by the
+ * processes are not included
+ */
+static void sizePrint(const char *nameClass, size_t size)
+{
+	resultPrint(nameClass, 1, "process", (double)size, "bytes");
+	resultPrint(nameClass, 100000, "processes", (double)size * 100000 / (1 << 20), "MB");
+}
+
+static bool sizeBench()
+{
+	sizePrint("Processing", sizeof(Processing));
+	sizePrint("LeafBenching", sizeof(LeafBenching));
+	sizePrint("TcpListening", sizeof(TcpListening));
+	sizePrint("TcpTransfering", sizeof(TcpTransfering));
+	sizePrint("SystemCommanding", sizeof(SystemCommanding));
+	sizePrint("SystemDebugging", sizeof(SystemDebugging));
+#if CONFIG_PROC_HAVE_COROUTINES
+	sizePrint("Coroutining", sizeof(Coroutining));
+#endif
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t numsLeafs[] = { 100, 10000, 50000 };
+	const size_t numLeafsCnt = sizeof(numsLeafs) / sizeof(numsLeafs[0]);
+	bool ok = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--json"))
+		{
+			outJson = true;
+			continue;
+		}
+
+		pCases = &argv[i];
+		numCases = argc - i;
+		break;
+	}
+
+	if (caseEnabled("size"))
+		ok = sizeBench();
+
+	if (ok && caseEnabled("tick"))
+	{
+		for (size_t i = 0; ok && i < numLeafsCnt; ++i)
+			ok = tickBench(numsLeafs[i], 200000 / numsLeafs[i] + 10, false);
+	}
+
+	if (ok && caseEnabled("idle"))
+	{
+		for (size_t i = 0; ok && i < numLeafsCnt; ++i)
+			ok = tickBench(numsLeafs[i], 200000 / numsLeafs[i] + 10, true);
+	}
+
+	if (ok && caseEnabled("shape"))
+	{
+		ok = shapeBench("flat", 1, 10000, 30);
+		if (ok)
+			ok = shapeBench("chain", 500, 1, 500);
+		if (ok)
+			ok = shapeBench("binary", 13, 2, 30);
+		if (ok)
+			ok = shapeBench("wide", 4, 10, 30);
+	}
+
+	if (ok && caseEnabled("churn"))
+	{
+		for (size_t i = 0; ok && i < numLeafsCnt; ++i)
+			ok = churnBench(numsLeafs[i], 200000 / numsLeafs[i] + 1);
+	}
+
+	if (ok && caseEnabled("pipe"))
+	{
+		const size_t numsChildren[] = { 0, 1, 4, 16 };
+
+		for (size_t i = 0; ok && i < sizeof(numsChildren) / sizeof(numsChildren[0]); ++i)
+			ok = pipeBench(numsChildren[i], 1000000 / (numsChildren[i] + 1));
+	}
+
+	if (ok && caseEnabled("render"))
+	{
+		ok = renderBench("render", 3, 10, true, 200);
+		if (ok)
+			ok = renderBench("walk", 1, 10000, false, 200);
+	}
+
+	if (ok && caseEnabled("log"))
+		ok = logBench(100000);
+#ifndef _WIN32
+	if (ok && caseEnabled("tcp"))
+		ok = tcpBench(16384, 256 << 20, 20000);
+#endif
+	Processing::applicationClose();
+
+	return ok ? 0 : 1;
+}
+
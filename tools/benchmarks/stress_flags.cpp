@@ -0,0 +1,354 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+
+#include "Processing.h"
+
+using namespace std;
+
+/*
+ * Stress test of the status flags of processes.
+ * Children run on their own internal drivers. The parent polls
+ * their flags and results from its own thread every tick.
+ * Afterwards single failing children are started one after
+ * another. The parent polls childrenSuccess() meanwhile.
+ * Another thread renders the tree with the process infos and
+ * the profile and resets the profiling counters all the time.
+ * Build with ThreadSanitizer to check the flags for data races.
+ *
+ * Usage: stress_flags [number of children]
+ *
+ * Return: 0 if every result was visible together with its flag
+ * and no failing child was counted as positive
+ */
+
+#define dNumParallel		8
+#define dNumChildrenDefault	400
+#define dNumPollsFailing	100
+#define dSizeBufMonitor		16384
+
+static atomic<bool> monitoring(true);
+
+class Counting : public Processing
+{
+
+public:
+
+	static Counting *create(int numTicks)
+	{
+		return new dNoThrow Counting(numTicks);
+	}
+
+protected:
+
+	Counting(int numTicks)
+		: Processing("Counting")
+		, mNumTicks(numTicks)
+		, mSum(0)
+	{}
+
+	virtual ~Counting() {}
+
+private:
+
+	Counting() = delete;
+	Counting(const Counting &) = delete;
+	Counting &operator=(const Counting &) = delete;
+
+	Success process()
+	{
+		mSum += mNumTicks;
+
+		if (--mNumTicks > 0)
+			return Pending;
+
+		// Both results occur
+		return mSum & 1 ? Positive : -3;
+	}
+
+	// Rendered by the monitor while the driver ticks
+	void processInfo(char *pBuf, char *pBufEnd)
+	{
+		dInfo("Sum\t\t%d\n", mSum);
+	}
+
+	int mNumTicks;
+	int mSum;
+
+};
+
+class Failing : public Processing
+{
+
+public:
+
+	static Failing *create(int numTicks)
+	{
+		return new dNoThrow Failing(numTicks);
+	}
+
+protected:
+
+	Failing(int numTicks)
+		: Processing("Failing")
+		, mNumTicks(numTicks)
+	{}
+
+	virtual ~Failing() {}
+
+private:
+
+	Failing() = delete;
+	Failing(const Failing &) = delete;
+	Failing &operator=(const Failing &) = delete;
+
+	Success process()
+	{
+		if (--mNumTicks > 0)
+			return Pending;
+
+		return -2;
+	}
+
+	int mNumTicks;
+
+};
+
+class FlagsPolling : public Processing
+{
+
+public:
+
+	static FlagsPolling *create(size_t numChildren)
+	{
+		return new dNoThrow FlagsPolling(numChildren);
+	}
+
+protected:
+
+	FlagsPolling(size_t numChildren)
+		: Processing("FlagsPolling")
+		, mNumChildrenTotal(numChildren)
+		, mNumStarted(0)
+		, mNumPolls(0)
+		, mNumOk(0)
+		, mNumBad(0)
+		, mFlagsDone(false)
+		, mpFailing(NULL)
+		, mNumFailingStarted(0)
+		, mNumFailingPolls(0)
+	{
+		for (size_t i = 0; i < dNumParallel; ++i)
+			mpChildren[i] = NULL;
+	}
+
+	virtual ~FlagsPolling() {}
+
+private:
+
+	FlagsPolling() = delete;
+	FlagsPolling(const FlagsPolling &) = delete;
+	FlagsPolling &operator=(const FlagsPolling &) = delete;
+
+	Success process()
+	{
+		if (mFlagsDone)
+			return failingPoll();
+
+		Processing *pChild;
+		bool busy = false;
+
+		for (size_t i = 0; i < dNumParallel; ++i)
+		{
+			if (!mpChildren[i] && mNumStarted < mNumChildrenTotal)
+			{
+				mpChildren[i] = start(Counting::create(50 + mNumStarted % 7),
+										DrivenByNewInternalDriver);
+				++mNumStarted;
+			}
+
+			pChild = mpChildren[i];
+			if (!pChild)
+				continue;
+
+			busy = true;
+			childPoll(pChild, i);
+		}
+
+		if (busy || mNumStarted < mNumChildrenTotal)
+			return Pending;
+
+		printf("children %zu polls %zu ok %zu bad %zu\n",
+				mNumStarted, mNumPolls, mNumOk, mNumBad);
+
+		mFlagsDone = true;
+
+		return Pending;
+	}
+
+	// The only child fails. It must never count as positive
+	Success failingPoll()
+	{
+		if (!mpFailing)
+		{
+			if (mNumFailingStarted >= mNumChildrenTotal)
+			{
+				printf("failing %zu polls %zu bad %zu\n",
+						mNumFailingStarted, mNumFailingPolls, mNumBad);
+
+				return mNumBad ? -1 : Positive;
+			}
+
+			mpFailing = start(Failing::create(1 + mNumFailingStarted % 5),
+										DrivenByNewInternalDriver);
+			if (!mpFailing)
+				return -1;
+
+			++mNumFailingStarted;
+		}
+
+		for (size_t i = 0; i < dNumPollsFailing; ++i)
+		{
+			++mNumFailingPolls;
+
+			if (childrenSuccess() != Positive)
+				continue;
+
+			++mNumBad;
+			printf("children positive but child failed\n");
+			break;
+		}
+
+		if (mpFailing->progress())
+			return Pending;
+
+		repel(mpFailing);
+		mpFailing = NULL;
+
+		return Pending;
+	}
+
+	// The result must be visible once the flag is
+	void childPoll(Processing *pChild, size_t idx)
+	{
+		++mNumPolls;
+
+		if (pChild->processDone() && pChild->success() == Pending)
+		{
+			++mNumBad;
+			printf("processing done but result pending\n");
+		}
+
+		if (pChild->progress())
+			return;
+
+		if (pChild->success() == Pending)
+		{
+			++mNumBad;
+			printf("finished but result pending\n");
+		}
+		else
+			++mNumOk;
+
+		repel(pChild);
+		mpChildren[idx] = NULL;
+	}
+
+	size_t mNumChildrenTotal;
+	size_t mNumStarted;
+	size_t mNumPolls;
+	size_t mNumOk;
+	size_t mNumBad;
+	Processing *mpChildren[dNumParallel];
+	bool mFlagsDone;
+	Processing *mpFailing;
+	size_t mNumFailingStarted;
+	size_t mNumFailingPolls;
+
+};
+
+// Like the commands of SystemDebugging
+static void monitorRun(Processing *pApp)
+{
+	static char buf[dSizeBufMonitor];
+	size_t numRenders = 0;
+
+	while (monitoring)
+	{
+		pApp->processTreeStr(buf, buf + sizeof(buf));
+#if CONFIG_PROC_HAVE_PROFILING
+		pApp->profileTopStr(buf, buf + sizeof(buf), 5);
+
+		if (!(numRenders % 16))
+			pApp->profileReset();
+#endif
+		++numRenders;
+	}
+
+	printf("renders %zu\n", numRenders);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t numChildren = dNumChildrenDefault;
+	FlagsPolling *pApp;
+	thread *pMonitor;
+	Success success;
+
+	if (argc > 1)
+		numChildren = strtoul(argv[1], NULL, 10);
+
+	pApp = FlagsPolling::create(numChildren);
+	if (!pApp)
+	{
+		fprintf(stderr, "could not create process\n");
+		return 1;
+	}
+
+	pMonitor = new thread(monitorRun, pApp);
+
+	while (pApp->progress())
+		pApp->treeTick();
+
+	monitoring = false;
+	pMonitor->join();
+	delete pMonitor;
+
+	success = pApp->success();
+
+	Processing::destroy(pApp);
+	Processing::applicationClose();
+
+	return success == Positive ? 0 : 1;
+}
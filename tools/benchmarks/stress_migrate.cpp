@@ -0,0 +1,293 @@
+/*
+  This file is part of the DSP-Crowd project
+  https://www.dsp-crowd.com
+
+  Author(s):
+      - Johannes Natter, office@dsp-crowd.com
+
+  File created on 16.10.2026
+
+  Copyright (C) 2026, Johannes Natter
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+#include "Processing.h"
+#include "ThreadPooling.h"
+
+using namespace std;
+using namespace chrono;
+
+/*
+ * Stress test of driver migration.
+ * Migratable children alternate between hot and cold phases.
+ * They are promoted to their own drivers and demoted back
+ * to their parent over and over. Meanwhile other threads
+ * call wakeup() on them. Build with ThreadSanitizer or
+ * AddressSanitizer to check the retired driver contexts.
+ * With 'pool' the promoted children are driven by the
+ * workers of ThreadPooling instead of own threads.
+ *
+ * Usage: stress_migrate [number of phases] [pool]
+ *
+ * Return: 0 if the children have been migrated
+ */
+
+#define dNumChildren		4
+#define dNumWakers			2
+#define dNumPhasesDefault	40
+#define dDurPhaseMs			20
+#define dDurHotUs			500
+
+static atomic<bool> hot(false);
+static atomic<size_t> numMoves(0);
+static atomic<size_t> numWakeups(0);
+
+class Migrating : public Processing
+{
+
+public:
+
+	static Migrating *create()
+	{
+		return new dNoThrow Migrating;
+	}
+
+protected:
+
+	Migrating()
+		: Processing("Migrating")
+		, mIdThread()
+	{
+		migrationSet(true);
+	}
+
+	virtual ~Migrating() {}
+
+private:
+
+	Migrating(const Migrating &) = delete;
+	Migrating &operator=(const Migrating &) = delete;
+
+	Success process()
+	{
+		thread::id idThread = this_thread::get_id();
+
+		if (idThread != mIdThread)
+		{
+			mIdThread = idThread;
+			++numMoves;
+		}
+
+		if (!hot)
+			return Pending;
+
+		steady_clock::time_point tEnd = steady_clock::now() + microseconds(dDurHotUs);
+
+		while (steady_clock::now() < tEnd)
+			;
+
+		return Pending;
+	}
+
+	thread::id mIdThread;
+
+};
+
+class MigrationStressing : public Processing
+{
+
+public:
+
+	static MigrationStressing *create(size_t numPhases)
+	{
+		return new dNoThrow MigrationStressing(numPhases);
+	}
+
+	// Woken up by other threads. Set before the first tick
+	Processing *mpChildren[dNumChildren];
+	atomic<bool> mPhasesDone;
+	atomic<bool> mWakersDone;
+
+protected:
+
+	MigrationStressing(size_t numPhases)
+		: Processing("MigrationStressing")
+		, mPhasesDone(false)
+		, mWakersDone(false)
+		, mNumPhases(numPhases)
+		, mNumPhasesDone(0)
+		, mStartMs(0)
+	{
+		for (size_t i = 0; i < dNumChildren; ++i)
+			mpChildren[i] = NULL;
+	}
+
+	virtual ~MigrationStressing() {}
+
+private:
+
+	MigrationStressing() = delete;
+	MigrationStressing(const MigrationStressing &) = delete;
+	MigrationStressing &operator=(const MigrationStressing &) = delete;
+
+	Success initialize()
+	{
+		for (size_t i = 0; i < dNumChildren; ++i)
+		{
+			mpChildren[i] = start(Migrating::create());
+			if (!mpChildren[i])
+				return procErrLog(-1, "could not create process");
+		}
+
+		mStartMs = clockMs();
+
+		return Positive;
+	}
+
+	Success process()
+	{
+		uint32_t curTimeMs = clockMs();
+
+		if (!mPhasesDone)
+		{
+			if (curTimeMs - mStartMs < dDurPhaseMs)
+				return Pending;
+
+			mStartMs = curTimeMs;
+			hot = !hot;
+
+			if (++mNumPhasesDone < mNumPhases)
+				return Pending;
+
+			mPhasesDone = true;
+		}
+
+		// Children are removed after the wakers stopped
+		if (!mWakersDone)
+			return Pending;
+
+		for (size_t i = 0; i < dNumChildren; ++i)
+		{
+			if (!mpChildren[i])
+				continue;
+
+			cancel(mpChildren[i]);
+
+			if (mpChildren[i]->progress())
+				return Pending;
+
+			repel(mpChildren[i]);
+			mpChildren[i] = NULL;
+		}
+
+		// First tick of each child counts as a move
+		return numMoves > dNumChildren ? Positive : -1;
+	}
+
+	size_t mNumPhases;
+	size_t mNumPhasesDone;
+	uint32_t mStartMs;
+
+};
+
+static void wakersRun(MigrationStressing *pApp)
+{
+	size_t i = 0;
+
+	while (!pApp->mPhasesDone)
+	{
+		pApp->mpChildren[i++ % dNumChildren]->wakeup();
+		++numWakeups;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t numPhases = dNumPhasesDefault;
+	MigrationStressing *pApp;
+	thread *pWakers[dNumWakers];
+	Success success;
+
+	if (argc > 1)
+		numPhases = strtoul(argv[1], NULL, 10);
+
+	if (argc > 2 && !strcmp(argv[2], "pool"))
+	{
+		if (!ThreadPooling::start(2))
+		{
+			fprintf(stderr, "could not start thread pool\n");
+			return 1;
+		}
+
+		ThreadPooling::driversInternalReplace();
+	}
+
+	Processing::migrationThresholdsSet(200, 100);
+
+	pApp = MigrationStressing::create(numPhases);
+	if (!pApp)
+	{
+		fprintf(stderr, "could not create process\n");
+		return 1;
+	}
+
+	while (!pApp->initDone() && pApp->progress())
+		pApp->treeTick();
+
+	if (!pApp->initDone())
+	{
+		Processing::destroy(pApp);
+		return 1;
+	}
+
+	for (size_t i = 0; i < dNumWakers; ++i)
+		pWakers[i] = new thread(wakersRun, pApp);
+
+	while (!pApp->mPhasesDone)
+		pApp->treeTick();
+
+	for (size_t i = 0; i < dNumWakers; ++i)
+	{
+		pWakers[i]->join();
+		delete pWakers[i];
+	}
+
+	pApp->mWakersDone = true;
+
+	while (pApp->progress())
+		pApp->treeTick();
+
+	success = pApp->success();
+
+	printf("migrations %zu wakeups %zu\n",
+			(size_t)numMoves - dNumChildren, (size_t)numWakeups);
+
+	Processing::destroy(pApp);
+	Processing::applicationClose();
+
+	return success == Positive ? 0 : 1;
+}
@@ -90,7 +90,11 @@ Success ChildExecuting::process()
 	case StTalk:
 
 		if (diffMs < 5000)
+		{
+			// Not ticked until done
+			sleepSet(5000 - diffMs);
 			break;
+		}
 
 		procInfLog("Waiting done.");
 
@@ -157,6 +157,18 @@ void Introducing::childrenStart(size_t idx)
 	 * - There are two or more CPU-bound processes AND
 	 * - the target system hat two or more CPUs!
 	 */
+#if CONFIG_PROC_HAVE_DRIVERS
+	/*
+	 * Optional: Configure the new thread.
+	 * Affinity, scheduling policy, stack size and NUMA node
+	 */
+	ConfigDriver config;
+
+	config.pName = "ChildExecuting";
+	config.sizeStack = 256 * 1024;
+
+	pChild->configDriverSet(config);
+#endif
 	start(pChild, DrivenByNewInternalDriver);
 }
 
@@ -124,8 +124,10 @@ int main(int argc, char *argv[])
 		 * Every real system needs sleep!
 		 * Sleep as long as you like.
 		 * This is the only place in which we use a sleep!
+		 * We wake up earlier if a socket of the tree
+		 * gets ready or a process requested a timeout.
 		 */
-		this_thread::sleep_for(chrono::milliseconds(15));
+		pApp->eventsWait(15);
 
 		/*
 		 * Check if the application is still doing _something_!
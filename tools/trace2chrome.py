@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+
+# Converts a binary trace dump of Processing::traceDump()
+# to the Chrome trace event format (JSON).
+# Open the result with https://ui.perfetto.dev or chrome://tracing
+#
+# Usage: trace2chrome.py trace.bin [trace.json]
+#
+# Dump format. Little endian
+# - Header: "PTRC", uint32_t version
+# - Records: uint64_t tNs, uint64_t idProc, uint32_t idDriver,
+#            uint8_t type, uint8_t valOld, uint8_t valNew,
+#            uint8_t lenStr, char str[lenStr]
+
+import sys
+import json
+import struct
+
+TeStart = 1
+TeCancel = 2
+TeRepel = 3
+TeDestroy = 4
+TeStateAbstract = 5
+TeState = 6
+
+namesType = {
+	TeStart: 'start',
+	TeCancel: 'cancel',
+	TeRepel: 'repel',
+	TeDestroy: 'destroy',
+}
+
+namesStateAbstract = [
+	'Existent',
+	'Initializing',
+	'Processing',
+	'DownShutting',
+	'ChildrenUnusedSet',
+	'FinishedPrepare',
+	'Finished',
+]
+
+namesDriver = [
+	'Parent',
+	'NewInternal',
+	'External',
+]
+
+def recordsRead(fileName):
+
+	with open(fileName, 'rb') as f:
+		data = f.read()
+
+	if data[:4] != b'PTRC':
+		raise ValueError('not a trace dump')
+
+	version, = struct.unpack_from('<I', data, 4)
+	if version != 1:
+		raise ValueError('unsupported version %d' % version)
+
+	recs = []
+	pos = 8
+
+	while pos + 24 <= len(data):
+		tNs, idProc, idDriver, typ, valOld, valNew, lenStr = \
+			struct.unpack_from('<QQIBBBB', data, pos)
+		pos += 24
+
+		s = data[pos:pos + lenStr].decode(errors = 'replace')
+		pos += lenStr
+
+		recs.append((tNs, idProc, idDriver, typ, valOld, valNew, s))
+
+	recs.sort(key = lambda r: r[0])
+
+	return recs
+
+def traceCreate(recs):
+
+	events = []
+
+	if not recs:
+		return events
+
+	t0 = recs[0][0]
+	tEnd = recs[-1][0]
+
+	def us(tNs):
+		return (tNs - t0) / 1000.0
+
+	# Process is shown in the driver executing its states
+	driverOfProc = {}
+	namesProc = {}
+	tids = {}
+
+	for tNs, idProc, idDriver, typ, valOld, valNew, s in recs:
+		if typ in (TeStateAbstract, TeState):
+			driverOfProc.setdefault(idProc, idDriver)
+		if typ == TeStart and s:
+			namesProc[idProc] = s
+
+	def tid(idProc):
+		if idProc not in tids:
+			tids[idProc] = 2 * len(tids) + 1
+		return tids[idProc]
+
+	statesOpen = {}
+
+	def stateClose(key, tNs):
+		if key not in statesOpen:
+			return
+
+		tStart, name, pid, t = statesOpen.pop(key)
+
+		events.append({
+			'name': name, 'ph': 'X', 'pid': pid, 'tid': t,
+			'ts': us(tStart), 'dur': us(tNs) - us(tStart),
+		})
+
+	for tNs, idProc, idDriver, typ, valOld, valNew, s in recs:
+		pid = driverOfProc.get(idProc, idDriver)
+
+		if typ == TeStateAbstract:
+			stateClose((idProc, 0), tNs)
+
+			if valNew < len(namesStateAbstract):
+				name = namesStateAbstract[valNew]
+			else:
+				name = 'State %d' % valNew
+
+			statesOpen[(idProc, 0)] = (tNs, name, pid, tid(idProc))
+			continue
+
+		if typ == TeState:
+			stateClose((idProc, 1), tNs)
+
+			name = s if s else 'mState %d' % valNew
+
+			statesOpen[(idProc, 1)] = (tNs, name, pid, tid(idProc) + 1)
+			continue
+
+		args = {}
+		if typ == TeStart and valNew < len(namesDriver):
+			args['driver'] = namesDriver[valNew]
+
+		events.append({
+			'name': namesType.get(typ, 'event %d' % typ), 'ph': 'i', 's': 't',
+			'pid': pid, 'tid': tid(idProc), 'ts': us(tNs), 'args': args,
+		})
+
+		if typ == TeDestroy:
+			stateClose((idProc, 0), tNs)
+			stateClose((idProc, 1), tNs)
+
+	for key in list(statesOpen.keys()):
+		stateClose(key, tEnd)
+
+	# Names of tracks
+	for idDriver in sorted(set(r[2] for r in recs) | set(driverOfProc.values())):
+		events.append({
+			'name': 'process_name', 'ph': 'M', 'pid': idDriver,
+			'args': { 'name': 'Driver %d' % idDriver },
+		})
+
+	for idProc, t in tids.items():
+		name = '%s 0x%x' % (namesProc.get(idProc, 'Process'), idProc)
+		pid = driverOfProc.get(idProc, 0)
+
+		events.append({
+			'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': t,
+			'args': { 'name': name },
+		})
+		events.append({
+			'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': t + 1,
+			'args': { 'name': name + ' mState' },
+		})
+
+	return events
+
+if __name__ == '__main__':
+
+	if len(sys.argv) < 2:
+		print('Usage: %s trace.bin [trace.json]' % sys.argv[0])
+		sys.exit(1)
+
+	fileOut = sys.argv[2] if len(sys.argv) > 2 else 'trace.json'
+
+	recs = recordsRead(sys.argv[1])
+	events = traceCreate(recs)
+
+	with open(fileOut, 'w') as f:
+		json.dump({ 'traceEvents': events, 'displayTimeUnit': 'ns' }, f)
+
+	print('%d records -> %d events written to %s' % (len(recs), len(events), fileOut))
+